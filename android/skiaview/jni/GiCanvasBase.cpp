@@ -60,6 +60,15 @@ bool GiCanvasBase::rawBeziers(const GiContext* ctx, const Point2d* pxs, int coun
     if (ret) {
         mgvector<float> arr(&pxs[0].x, 2 * count);
         ret = drawBeziers(arr);
+        
+        if (!ret) {                 // Draw as polyline if the derived class can't draw beziers.
+            int n = 0;
+            const Point2d* lines = _flatten.flatten(count, pxs, 0.5f, n);
+            if (lines && n > 1) {
+                mgvector<float> arr2(&lines[0].x, 2 * n);
+                ret = drawLines(arr2);
+            }
+        }
     }
 
     return ret;
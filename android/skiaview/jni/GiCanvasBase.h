@@ -9,6 +9,7 @@
 #include <gicanvas.h>
 #include <gigraph.h>
 #include <mgvector.h>
+#include <mgflatten.h>
 
 //! The canvas adapter class.
 /** \ingroup GRAPH_SKIA
@@ -90,6 +91,7 @@ private:
     GiColor         _bkcolor;
     GiContext       _gictx;
     int             _ctxstatus;
+    MgFlattenCache  _flatten;
 };
 
 #endif // __TOUCHVG_SWIG_CANVAS_H_
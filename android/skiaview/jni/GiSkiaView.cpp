@@ -74,6 +74,9 @@ bool GiSkiaView::loadShapes(MgStorageBase* s)
     }
     else {
         ret = _view->_shapes && s && _view->_shapes->load(s);
+        if (ret) {
+            _view->_shapes->applyOrigin(_view->_canvas->xf());  // 显示原点与文档原点相同
+        }
     }
     _view->regen();
     
@@ -0,0 +1,400 @@
+// docbench.cpp: 用 RandomParam 生成固定种子的随机图形，测试常用操作的耗时
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+// 用法: docbench [最大图形数，默认1000000] [统计文件名前缀]
+// 给出统计文件名前缀时另外统计绘制一帧，写出 前缀-图形数.json 和 Chrome 跟踪文件 前缀-图形数.trace.json
+// 输出每行为 操作名 图形数 操作次数 耗时(ms) 校验值，校验值用于确认各版本的结果相同
+
+#include <testgraph/RandomShape.cpp>
+#include <mgshapest.h>
+#include <mgcmd.h>
+#include <mgsnap.h>
+#include <mgcurv.h>
+#include <ginullcanvas.h>
+#include <gixform.h>
+#include <gistats.h>
+#include "../src/shape/mgboxsel.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+#include <list>
+
+typedef MgShapesT<std::list<MgShape*> > Shapes;
+
+static double now()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static void report(const char* name, long shapes, long ops, double start, double check)
+{
+    printf("%s\t%ld\t%ld\t%.2f\t%.10g\n", name, shapes, ops, now() - start, check);
+    fflush(stdout);
+}
+
+// 在内存中按节点树保存内容的存取对象，按名称查找字段
+class MemStorage : public MgStorage
+{
+public:
+    MemStorage() { clear(); }
+
+    void clear()
+    {
+        m_nodes.assign(1, Node());
+        m_values.clear();
+        m_cur = 0;
+    }
+
+    bool readNode(const char* name, int index, bool ended)
+    {
+        if (ended) {
+            m_cur = m_nodes[m_cur].parent;
+            return true;
+        }
+        Node& node = m_nodes[m_cur];
+        size_t n = node.children.size();
+        for (size_t k = 0; k < n; k++) {
+            size_t i = (node.hint + k) % n;     // 通常按顺序读取
+            const Node& child = m_nodes[node.children[i]];
+            if (child.index == index && strcmp(child.name, name) == 0) {
+                node.hint = i + 1;
+                m_cur = node.children[i];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool writeNode(const char* name, int index, bool ended)
+    {
+        if (ended) {
+            m_cur = m_nodes[m_cur].parent;
+        }
+        else {
+            Node node;
+            node.name = name;
+            node.index = index;
+            node.parent = m_cur;
+            m_nodes.push_back(node);
+            m_nodes[m_cur].children.push_back((int)m_nodes.size() - 1);
+            m_cur = (int)m_nodes.size() - 1;
+        }
+        return true;
+    }
+
+    bool readBool(const char* name, bool defvalue) { return readInt(name, defvalue) != 0; }
+    float readFloat(const char* name, float defvalue)
+    {
+        const Field* f = find(name);
+        return f && f->count > 0 ? m_values[f->offset] : defvalue;
+    }
+    int readFloatArray(const char* name, float* values, int count)
+    {
+        const Field* f = find(name);
+        if (!f)
+            return 0;
+        for (int i = 0; values && i < f->count && i < count; i++)
+            values[i] = m_values[f->offset + i];
+        return f->count;
+    }
+    int readString(const char* name, wchar_t* value, int count)
+    {
+        const Field* f = find(name);
+        if (!f)
+            return 0;
+        for (int i = 0; value && i < f->count && i < count; i++)
+            value[i] = (wchar_t)m_values[f->offset + i];
+        return f->count;
+    }
+
+    void writeBool(const char* name, bool value) { writeInt(name, value); }
+    void writeFloat(const char* name, float value) { writeFloatArray(name, &value, 1); }
+    void writeFloatArray(const char* name, const float* values, int count)
+    {
+        Field f = { name, (int)m_values.size(), count };
+        m_nodes[m_cur].fields.push_back(f);
+        m_values.insert(m_values.end(), values, values + count);
+    }
+    void writeString(const char* name, const wchar_t* value)
+    {
+        std::vector<float> arr;
+        for (; value && *value; value++)
+            arr.push_back((float)*value);
+        writeFloatArray(name, arr.empty() ? NULL : &arr.front(), (int)arr.size());
+    }
+
+protected:
+    int readInt(const char* name, int defvalue)
+    {
+        const Field* f = find(name);
+        return f && f->count > 0 ? (int)m_values[f->offset] : defvalue;
+    }
+    void writeInt(const char* name, int value)
+    {
+        float f = (float)value;
+        writeFloatArray(name, &f, 1);
+    }
+
+private:
+    struct Field {
+        const char* name;               // 调用者传入的常量字符串
+        int         offset;
+        int         count;
+    };
+    struct Node {
+        const char* name;
+        int         index;
+        int         parent;
+        size_t      hint;               // 下次查找子节点的起始位置
+        std::vector<int>    children;
+        std::vector<Field>  fields;
+        Node() : name(""), index(-1), parent(0), hint(0) {}
+    };
+
+    const Field* find(const char* name) const
+    {
+        const std::vector<Field>& fields = m_nodes[m_cur].fields;
+        for (size_t i = 0; i < fields.size(); i++) {
+            if (strcmp(fields[i].name, name) == 0)
+                return &fields[i];
+        }
+        return NULL;
+    }
+
+    std::vector<Node>   m_nodes;
+    std::vector<float>  m_values;
+    int                 m_cur;
+};
+
+class BenchView : public MgView
+{
+public:
+    GiTransform     xf;
+    GiGraphics      gs;
+    GiNullCanvas    canvas;
+    MgShapes*       doc;
+
+    BenchView(MgShapes* shapes) : gs(&xf), canvas(&gs), doc(shapes)
+    {
+        xf.setWndSize(1024, 768);
+    }
+
+    MgShapes* shapes() { return doc; }
+    GiTransform* xform() { return &xf; }
+    GiGraphics* graph() { return &gs; }
+    void regen() {}
+    void redraw(bool) {}
+};
+
+static Point2d randPoint(const Box2d& rect)
+{
+    return Point2d(rect.xmin + rect.width() * rand() / RAND_MAX,
+                   rect.ymin + rect.height() * rand() / RAND_MAX);
+}
+
+static void writeFile(const char* filename, const std::string& text)
+{
+    FILE* fp = fopen(filename, "w");
+    if (fp) {
+        fputs(text.c_str(), fp);
+        fclose(fp);
+    }
+}
+
+static void writeStats(const char* prefix, long count, const GiDrawStats& stats)
+{
+    char filename[256];
+
+    snprintf(filename, sizeof(filename), "%s-%ld.json", prefix, count);
+    writeFile(filename, stats.toJson() + "\n");
+    snprintf(filename, sizeof(filename), "%s-%ld.trace.json", prefix, count);
+    writeFile(filename, stats.toTrace());
+}
+
+static void benchDocument(long count, const char* statsPrefix)
+{
+    Shapes* shapes = new Shapes;
+    RandomParam param;
+    double start = now();
+
+    RandomParam::init(12345);
+    param.lineCount = count / 3;
+    param.rectCount = count / 3;
+    param.arcCount = 0;
+    param.curveCount = count - param.lineCount - param.rectCount;
+    param.initShapes(shapes);
+    shapes->afterChanged();                 // 添加后才设置的坐标
+    report("generate", count, count, start, shapes->getShapeCount());
+
+    MemStorage storage;
+    start = now();
+    shapes->save(&storage);
+    report("save", count, count, start, 0);
+
+    Shapes* loaded = new Shapes;
+    start = now();
+    loaded->load(&storage);
+    report("load", count, count, start, loaded->getShapeCount());
+    loaded->release();
+
+    Box2d extent;
+    start = now();
+    for (int i = 0; i < 10; i++) {
+        shapes->afterChanged();
+        extent = shapes->getExtent();
+    }
+    report("getExtent", count, 10, start, extent.width() + extent.height());
+
+    BenchView view(shapes);
+    view.xf.zoomTo(extent * view.xf.modelToWorld());
+    RECT_2D rc = { 0, 0, 1024, 768 };
+    start = now();
+    view.canvas.beginPaint(rc);
+    shapes->draw(view.gs);
+    view.canvas.endPaint();
+    report("drawAll", count, 1, start, view.canvas.getVertexes());
+
+    view.canvas.setChecksum(true);                  // 校验输出的图元，不计入上面的耗时
+    start = now();
+    view.canvas.beginPaint(rc);
+    shapes->draw(view.gs);
+    view.canvas.endPaint();
+    view.canvas.setChecksum(false);
+    report("drawChecksum", count, 1, start, view.canvas.getChecksum());
+
+    shapes->setDrawByType(true);
+    start = now();
+    view.canvas.beginPaint(rc);
+    shapes->draw(view.gs);
+    view.canvas.endPaint();
+    shapes->setDrawByType(false);
+    report("drawByType", count, 1, start, view.canvas.getVertexes());
+
+    view.xf.zoomScale(view.xf.getViewScale() * 8);     // 只显示中间部分
+    start = now();
+    view.canvas.beginPaint(rc);
+    shapes->draw(view.gs);
+    view.canvas.endPaint();
+    report("drawZoomed", count, 1, start, view.canvas.getVertexes());
+    view.xf.zoomTo(extent * view.xf.modelToWorld());
+
+    if (statsPrefix) {
+        GiDrawStats stats;
+        view.gs.setStats(&stats);
+        start = now();
+        view.canvas.beginPaint(rc);
+        shapes->draw(view.gs);
+        view.canvas.endPaint();
+        view.gs.setStats(NULL);
+        report("drawStats", count, 1, start, view.canvas.getTotalCalls());
+        writeStats(statsPrefix, count, stats);
+    }
+
+    const int kHits = count <= 10000 ? 1000 : 100;
+    const float tol = extent.width() / 200;
+    long found = 0;
+    srand(1);
+    start = now();
+    for (int i = 0; i < kHits; i++) {
+        Point2d nearpt;
+        Int32 segment;
+        found += shapes->hitTest(Box2d(randPoint(extent), tol, tol), nearpt, segment) ? 1 : 0;
+    }
+    report("hitTest", count, kHits, start, found);
+
+    const int kSnaps = count <= 10000 ? 200 : 20;
+    MgMotion motion;
+    Point2d sum;
+    motion.view = &view;
+    srand(2);
+    start = now();
+    for (int i = 0; i < kSnaps; i++) {
+        motion.pointM = randPoint(extent);
+        motion.point = motion.pointM * view.xf.modelToDisplay();
+        sum += mgGetCommandManager()->getSnap()->snapPoint(&motion, NULL, 0).asVector();
+    }
+    report("snapPoint", count, kSnaps, start, sum.x + sum.y);
+
+    const int kDrags = 50;
+    MgBoxSelector selector;
+    std::vector<UInt32> ids;
+    Point2d center (extent.center());
+    start = now();
+    selector.begin(shapes);
+    for (int i = 1; i <= kDrags; i++) {
+        Box2d box (center, extent.width() * i / kDrags, extent.height() * i / kDrags);
+        selector.update(box, i % 2 == 0);
+    }
+    selector.getSelection(ids);
+    selector.end();
+    report("boxSelect", count, kDrags, start, (double)ids.size());
+
+    long knotCount = mgMin(count, 100000L);
+    std::vector<Point2d> knots(knotCount);
+    std::vector<Vector2d> knotvs(knotCount);
+    srand(3);
+    for (long i = 0; i < knotCount; i++)
+        knots[i] = randPoint(extent);
+    start = now();
+    mgCubicSplines(knotCount, &knots.front(), &knotvs.front(), 0);
+    report("splineFit", count, knotCount, start, knotvs[knotCount / 2].length());
+
+    const int kMoves = 1000;                        // 放在最后，移动后的图形不影响上面的校验值
+    srand(4);
+    start = now();
+    for (int i = 0; i < kMoves; i++) {
+        MgShapesLock locker(shapes, MgShapesLock::Modify);
+        MgShape* sp = shapes->findShape((UInt32)RandomParam::RandInt(1, count));
+        if (sp) {
+            sp->shape()->offset(Vector2d(RandomParam::RandF(-50, 50), RandomParam::RandF(-50, 50)), -1);
+            sp->shape()->update();
+            shapes->afterShapeChanged(sp);
+        }
+        extent = shapes->getExtent();
+    }
+    report("moveShape", count, kMoves, start, extent.width() + extent.height());
+
+    long packed = 0;                                // 压缩存储顶点，校验值为压缩的图形数
+    start = now();
+    {
+        MgShapesLock locker(shapes, MgShapesLock::Edit);
+        void* it;
+        for (MgShape* sp = shapes->getFirstShape(it); sp; sp = shapes->getNextShape(it)) {
+            if (sp->shape()->isKindOf(MgBaseLines::Type()) && ((MgBaseLines*)sp->shape())->pack())
+                packed++;
+        }
+        shapes->freeIterator(it);
+    }
+    report("pack", count, count, start, packed);
+
+    view.xf.zoomTo(shapes->getExtent() * view.xf.modelToWorld());
+    start = now();                                  // 有损压缩，顶点数可能比 drawAll 的略少
+    view.canvas.beginPaint(rc);
+    shapes->draw(view.gs);
+    view.canvas.endPaint();
+    report("drawPacked", count, 1, start, view.canvas.getVertexes());
+
+    storage.clear();
+    shapes->save(&storage);
+    loaded = new Shapes;
+    start = now();
+    loaded->load(&storage);
+    report("loadPacked", count, count, start, loaded->getShapeCount());
+    loaded->release();
+
+    shapes->release();
+}
+
+int main(int argc, char* argv[])
+{
+    long maxCount = argc > 1 ? atol(argv[1]) : 1000000;
+    const char* statsPrefix = argc > 2 ? argv[2] : NULL;
+
+    for (long count = 1000; count <= maxCount; count *= 10)
+        benchDocument(count, statsPrefix);
+
+    return 0;
+}
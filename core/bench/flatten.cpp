@@ -0,0 +1,82 @@
+// flatten.cpp: 比较直接折线化与 MgFlattenCache 缓存折线化的速度和结果
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+// 输出每行为 名称 控制点数 曲线数 直接耗时(ms) 缓存耗时(ms) 结果不同的个数，有不同时返回非零
+
+#include <mgflatten.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+
+static float randf(float dMin, float dMax)
+{
+    return dMin + (dMax - dMin) * rand() / (float)RAND_MAX;
+}
+
+static double elapsed(clock_t start)
+{
+    return 1000.0 * (clock() - start) / CLOCKS_PER_SEC;
+}
+
+// 各曲线的控制点单独分配，正好 count 个，越界读取时可被内存检查工具发现
+static int benchFlatten(const char* name, int count, int curves, int rounds)
+{
+    std::vector<Point2d*> beziers(curves);
+    for (int c = 0; c < curves; c++) {
+        beziers[c] = new Point2d[count];
+        for (int i = 0; i < count; i++)
+            beziers[c][i].set(randf(0, 1000), randf(0, 1000));
+    }
+
+    const float tols[] = { 0.5f, 0.6f, 2.f };
+    std::vector<Point2d> lines;
+    MgFlattenCache cache;
+    long n1 = 0, n2 = 0;
+    int diff = 0;
+
+    clock_t start = clock();
+    for (int r = 0; r < rounds; r++) {
+        for (int c = 0; c < curves; c++) {
+            float tol = tols[r % 3];
+            Int32 n = mgFlattenBeziers(count, beziers[c], tol, NULL, 0);
+            lines.resize(n);
+            n1 += mgFlattenBeziers(count, beziers[c], tol, &lines.front(), n);
+        }
+    }
+    double t1 = elapsed(start);
+
+    start = clock();
+    for (int r = 0; r < rounds; r++) {
+        for (int c = 0; c < curves; c++) {
+            Int32 n = 0;
+            const Point2d* pts = cache.flatten(count, beziers[c], tols[r % 3], n);
+            n2 += n;
+            if (!pts || n < 2 || pts[0] != beziers[c][0] || pts[n - 1] != beziers[c][count - 1])
+                diff++;
+        }
+    }
+    double t2 = elapsed(start);
+
+    // 缓存按取整后的误差折线化，段数只会多于直接折线化的
+    if (n2 < n1)
+        diff++;
+    printf("%s\t%d\t%d\t%.2f\t%.2f\t%d\n", name, count, curves, t1, t2, diff);
+
+    for (int c = 0; c < curves; c++)
+        delete[] beziers[c];
+    return diff;
+}
+
+int main()
+{
+    int diff = 0;
+
+    srand(1);
+    diff += benchFlatten("single", 4, 16, 2000);
+    diff += benchFlatten("odd", 7, 16, 2000);       // 奇数个控制点
+    diff += benchFlatten("long", 31, 16, 500);
+    diff += benchFlatten("evict", 13, 100, 100);    // 曲线数多于缓存容量
+
+    return diff ? 1 : 0;
+}
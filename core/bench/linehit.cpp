@@ -0,0 +1,106 @@
+// linehit.cpp: 比较折线逐段点中与按线段索引点中的速度和结果
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+// 输出每行为 名称 顶点数 查询数 逐段耗时(ms) 索引耗时(ms) 结果不同的个数，有不同时返回非零
+
+#include <mgbasicsp.h>
+#include <mgshapet.h>
+#include <mgnear.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <vector>
+
+static float randf(float dMin, float dMax)
+{
+    return dMin + (dMax - dMin) * rand() / (float)RAND_MAX;
+}
+
+static double elapsed(clock_t start)
+{
+    return 1000.0 * (clock() - start) / CLOCKS_PER_SEC;
+}
+
+// 生成随机游走的折线或星形多边形，dupStep 大于0时每隔 dupStep 个顶点重复前一顶点
+static void makeLines(std::vector<Point2d>& pts, int count, bool closed, int dupStep)
+{
+    Point2d pt(500, 500);
+
+    pts.resize(count);
+    for (int i = 0; i < count; i++) {
+        if (dupStep > 0 && i > 0 && i % dupStep == 0) {
+            pts[i] = pts[i - 1];
+        }
+        else if (closed) {
+            pts[i] = Point2d(500, 500).polarPoint(i * _M_2PI / count, randf(300, 400));
+        }
+        else {
+            pt += Vector2d(randf(-1, 1), randf(-1, 1));
+            pts[i] = pt;
+        }
+    }
+}
+
+static int benchLines(const char* name, int count, bool closed, int dupStep, int n)
+{
+    std::vector<Point2d> pts;
+    makeLines(pts, count, closed, dupStep);
+
+    MgShapeT<MgLines> shape;
+    MgLines* lines = (MgLines*)shape.shape();
+    MgBaseShape* base = lines;
+    lines->resize(count);
+    for (int i = 0; i < count; i++)
+        base->setPoint(i, pts[i]);
+    lines->setClosed(closed);
+    base->update();
+
+    std::vector<Point2d> queries(n);
+    std::vector<float> tols(n);
+    for (int i = 0; i < n; i++) {
+        if (i % 3 == 0)
+            queries[i].set(randf(0, 1000), randf(0, 1000));
+        else
+            queries[i] = pts[rand() % count] + Vector2d(randf(-1, 1), randf(-1, 1));
+        if (dupStep > 0 && i % 4 == 0)          // 与重合顶点的Y坐标相同，检查零长度边
+            queries[i].y = pts[rand() % count / dupStep * dupStep].y;
+        tols[i] = randf(0, 5);
+    }
+
+    std::vector<float> dist1(n), dist2(n);
+    std::vector<Int32> seg1(n), seg2(n);
+    Point2d nearpt;
+
+    clock_t start = clock();
+    for (int i = 0; i < n; i++)
+        dist1[i] = mgLinesHit(count, &pts.front(), closed, queries[i], tols[i], nearpt, seg1[i]);
+    double t1 = elapsed(start);
+
+    start = clock();
+    for (int i = 0; i < n; i++)
+        dist2[i] = shape.shapec()->hitTest(queries[i], tols[i], nearpt, seg2[i]);
+    double t2 = elapsed(start);
+
+    int diff = 0;
+    for (int i = 0; i < n; i++) {
+        if (seg1[i] != seg2[i] || fabs(dist1[i] - dist2[i]) > 1e-4f)
+            diff++;
+    }
+    printf("%s\t%d\t%d\t%.2f\t%.2f\t%d\n", name, count, n, t1, t2, diff);
+
+    return diff;
+}
+
+int main()
+{
+    int diff = 0;
+
+    srand(1);
+    diff += benchLines("lines", 100000, false, 0, 200);
+    diff += benchLines("polygon", 2000, true, 0, 2000);
+    diff += benchLines("lines-dup", 20000, false, 7, 2000);
+    diff += benchLines("polygon-dup", 2000, true, 7, 5000);
+
+    return diff ? 1 : 0;
+}
@@ -0,0 +1,122 @@
+// ptinarea.cpp: 比较点在多边形内判断的逐点函数与批量函数的速度
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+// 输出每行为 名称 多边形数 顶点数 点数 逐点耗时(ms) 批量耗时(ms) 结果不同的个数
+
+#include <mglnrel.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+#include <algorithm>
+
+static float randf(float dMin, float dMax)
+{
+    return dMin + (dMax - dMin) * rand() / (float)RAND_MAX;
+}
+
+static double elapsed(clock_t start)
+{
+    return 1000.0 * (clock() - start) / CLOCKS_PER_SEC;
+}
+
+// 生成以center为中心的星形多边形，各顶点按角度排序，不会自交
+static void makePolygon(std::vector<Point2d>& pts, int count, const Point2d& center, float r)
+{
+    std::vector<float> angles(count);
+    for (int i = 0; i < count; i++)
+        angles[i] = randf(0, _M_2PI);
+    std::sort(angles.begin(), angles.end());
+    for (int i = 0; i < count; i++)
+        pts.push_back(center.polarPoint(angles[i], randf(r * 0.3f, r)));
+}
+
+static bool scalarInArea(const Point2d& pt, int count, const Point2d* vertexs)
+{
+    Int32 order;
+    return mgPtInArea(pt, count, vertexs, order) != kMgPtOutArea;
+}
+
+// 多个点对一个多边形
+static void benchPoints(int count, int n)
+{
+    std::vector<Point2d> polygon;
+    std::vector<Point2d> pts(n);
+    makePolygon(polygon, count, Point2d(500, 500), 500);
+    for (int i = 0; i < n; i++)
+        pts[i].set(randf(0, 1000), randf(0, 1000));
+
+    bool* expect = new bool[n];
+    bool* inside = new bool[n];
+    clock_t start = clock();
+    for (int i = 0; i < n; i++)
+        expect[i] = scalarInArea(pts[i], count, &polygon.front());
+    double t1 = elapsed(start);
+
+    start = clock();
+    mgPtsInArea(n, &pts.front(), count, &polygon.front(), inside);
+    double t2 = elapsed(start);
+
+    int diff = 0;
+    for (int i = 0; i < n; i++)
+        diff += (expect[i] != inside[i]) ? 1 : 0;
+    printf("points\t1\t%d\t%d\t%.2f\t%.2f\t%d\n", count, n, t1, t2, diff);
+
+    delete[] expect;
+    delete[] inside;
+}
+
+// 一个点对多个多边形
+static void benchPolygons(int polyCount, int n)
+{
+    std::vector<Point2d> vertexs;
+    std::vector<Int32> starts;
+    std::vector<Box2d> extents;
+
+    for (int p = 0; p < polyCount; p++)
+    {
+        starts.push_back((Int32)vertexs.size());
+        makePolygon(vertexs, 8 + rand() % 25, Point2d(randf(0, 1000), randf(0, 1000)), randf(5, 50));
+        extents.push_back(Box2d((Int32)vertexs.size() - starts.back(), &vertexs[starts.back()]));
+    }
+    starts.push_back((Int32)vertexs.size());
+
+    std::vector<Point2d> pts(n);
+    for (int i = 0; i < n; i++)
+        pts[i].set(randf(0, 1000), randf(0, 1000));
+
+    bool* inside = new bool[polyCount];
+    int found1 = 0, found2 = 0;
+    clock_t start = clock();
+    for (int i = 0; i < n; i++)
+    {
+        for (int p = 0; p < polyCount; p++)
+        {
+            if (extents[p].contains(pts[i])
+                && scalarInArea(pts[i], starts[p + 1] - starts[p], &vertexs[starts[p]]))
+                found1++;
+        }
+    }
+    double t1 = elapsed(start);
+
+    start = clock();
+    for (int i = 0; i < n; i++)
+        found2 += mgPtInAreas(pts[i], polyCount, &starts.front(), &vertexs.front(), &extents.front(), inside);
+    double t2 = elapsed(start);
+
+    printf("polygons\t%d\t%d\t%d\t%.2f\t%.2f\t%d\n", polyCount, (int)vertexs.size(), n,
+           t1, t2, abs(found1 - found2));
+    delete[] inside;
+}
+
+int main()
+{
+    srand(1);
+    benchPoints(8, 100000);
+    benchPoints(64, 100000);
+    benchPoints(1024, 20000);
+    benchPoints(16384, 2000);
+    benchPolygons(1000, 1000);
+    benchPolygons(10000, 200);
+    return 0;
+}
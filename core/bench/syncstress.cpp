@@ -0,0 +1,222 @@
+// syncstress.cpp: 多线程检查原子计数、读写锁、互斥锁、顺序锁和坐标系复制的一致性
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+// 输出每行为 名称 线程数 每线程次数 耗时(ms) 错误数，有错误时返回非零
+
+#include <mgshapest.h>
+#include <mgshapet.h>
+#include <mgbasicsp.h>
+#include <gisync.h>
+#include <gixform.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include <list>
+
+typedef MgShapesT<std::list<MgShape*> > Shapes;
+
+static const int kThreads = 8;
+static volatile long s_errors = 0;
+static int s_failed = 0;
+
+static double now()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static void addError()
+{
+    giInterlockedIncrement(&s_errors);
+}
+
+// 多个线程同时运行proc，返回耗时(ms)
+static double run(void* (*proc)(void*), void* arg)
+{
+    pthread_t threads[kThreads];
+    double start = now();
+
+    for (int i = 0; i < kThreads; i++)
+        pthread_create(&threads[i], NULL, proc, arg);
+    for (int i = 0; i < kThreads; i++)
+        pthread_join(threads[i], NULL);
+
+    return now() - start;
+}
+
+// 输出结果，errors 为线程结束后检查出的错误数
+static void report(const char* name, int loops, double ms, int errors)
+{
+    errors += (int)giInterlockedExchange(&s_errors, 0);
+    printf("%s\t%d\t%d\t%.1f\t%d\n", name, kThreads, loops, ms, errors);
+    s_failed += errors;
+}
+
+// 图形列表的改变次数
+static const int kChangeLoops = 1000000;
+
+static void* changeProc(void* arg)
+{
+    Shapes* shapes = (Shapes*)arg;
+    for (int i = 0; i < kChangeLoops; i++)
+        shapes->afterChanged();
+    return NULL;
+}
+
+// 读写锁：写方持锁期间不能有读方或其他写方
+static const int kLockLoops = 20000;
+static volatile long s_readers = 0;
+static volatile long s_writers = 0;
+static long s_written = 0;
+
+static void* lockProc(void* arg)
+{
+    MgLockRW* lockData = (MgLockRW*)arg;
+    unsigned int seed = (unsigned int)(size_t)&seed;
+
+    for (int i = 0; i < kLockLoops; i++) {
+        bool forWrite = (rand_r(&seed) % 8 == 0);
+        if (!lockData->lock(forWrite, 10000)) {
+            addError();
+            continue;
+        }
+        if (forWrite) {
+            if (giInterlockedIncrement(&s_writers) != 1 || giAtomicLoad(&s_readers) != 0)
+                addError();
+            s_written++;                        // 只在写锁内修改
+            giInterlockedDecrement(&s_writers);
+        }
+        else {
+            giInterlockedIncrement(&s_readers);
+            if (giAtomicLoad(&s_writers) != 0)
+                addError();
+            giInterlockedDecrement(&s_readers);
+        }
+        lockData->unlock(forWrite);
+    }
+    return NULL;
+}
+
+// 互斥锁保护的普通计数
+static const int kMutexLoops = 200000;
+static GiMutex s_mutex;
+static long s_guarded = 0;
+
+static void* mutexProc(void*)
+{
+    for (int i = 0; i < kMutexLoops; i++) {
+        GiMutexLock locker(s_mutex);
+        s_guarded++;
+    }
+    return NULL;
+}
+
+// 内存池的并发分配和释放
+static const int kPoolLoops = 20000;
+
+static void* poolProc(void*)
+{
+    void* items[16];
+    for (int i = 0; i < kPoolLoops; i++) {
+        for (int j = 0; j < 16; j++) {
+            items[j] = MgObjectPool<MgLines>::allocate();
+            *(int*)items[j] = j;
+        }
+        for (int j = 0; j < 16; j++) {
+            if (*(int*)items[j] != j)
+                addError();
+            MgObjectPool<MgLines>::deallocate(items[j]);
+        }
+    }
+    return NULL;
+}
+
+// 顺序锁：读方不能读到写了一半的状态
+static const int kSeqLoops = 200000;
+static GiSeqLock s_seqlock;
+static GiMutex s_seqWriter;
+static volatile long s_state[2] = { 0, 0 };
+
+static void* seqProc(void*)
+{
+    unsigned int seed = (unsigned int)(size_t)&seed;
+
+    for (int i = 0; i < kSeqLoops; i++) {
+        if (rand_r(&seed) % 16 == 0) {
+            GiMutexLock locker(s_seqWriter);
+            s_seqlock.beginWrite();
+            s_state[0] = s_state[0] + 1;
+            s_state[1] = -s_state[0];
+            s_seqlock.endWrite();
+        }
+        else {
+            long seq, a, b;
+            do {
+                seq = s_seqlock.beginRead();
+                a = s_state[0];
+                b = s_state[1];
+            } while (s_seqlock.retryRead(seq));
+            if (a != -b)
+                addError();
+        }
+    }
+    return NULL;
+}
+
+// 坐标系：一个线程放缩，其他线程复制的坐标系中显示比例、中心点和变换矩阵一致
+static const int kXformLoops = 50000;
+static GiTransform s_xform;
+static volatile long s_xformWriter = 0;
+
+static void* xformProc(void*)
+{
+    const bool writer = (giInterlockedIncrement(&s_xformWriter) == 1);
+
+    for (int i = 0; i < kXformLoops; i++) {
+        if (writer) {
+            s_xform.zoomScale(0.5f + (i % 100) * 0.02f);
+            s_xform.zoomPan((float)(i % 7) - 3.f, (float)(i % 5) - 2.f);
+        }
+        else {
+            GiTransform xf(s_xform);
+            Point2d pt(xf.getCenterW() * xf.worldToDisplay());
+            float w2d = xf.getViewScale() * xf.getDpiX() / 25.4f;
+            if (fabs(pt.x - xf.getWidth() * 0.5f) > 0.1f || fabs(pt.y - xf.getHeight() * 0.5f) > 0.1f
+                || fabs(xf.worldToDisplay().m11 - w2d) > w2d * 1e-5f)
+                addError();
+        }
+    }
+    return NULL;
+}
+
+int main()
+{
+    Shapes* shapes = new Shapes;
+    UInt32 count0 = shapes->getChangeCount();
+    double ms = run(changeProc, shapes);
+    report("changeCount", kChangeLoops, ms,
+           shapes->getChangeCount() - count0 != (UInt32)(kThreads * kChangeLoops));
+    shapes->release();
+
+    MgLockRW lockData;
+    ms = run(lockProc, &lockData);
+    report("lockRW", kLockLoops, ms, lockData.lockedForRead() || lockData.lockedForWrite());
+
+    ms = run(mutexProc, NULL);
+    report("mutex", kMutexLoops, ms, s_guarded != kThreads * kMutexLoops);
+
+    ms = run(poolProc, NULL);
+    report("objectPool", kPoolLoops, ms, 0);
+
+    ms = run(seqProc, NULL);
+    report("seqLock", kSeqLoops, ms, 0);
+
+    s_xform.setWndSize(1024, 768);
+    s_xform.setWorldLimits(Box2d());
+    ms = run(xformProc, NULL);
+    report("xformCopy", kXformLoops, ms, 0);
+
+    return s_failed ? 1 : 0;
+}
@@ -505,6 +505,27 @@ public:
         return unionWith(*this, box);
     }
     
+#ifndef SWIG
+    //! 合并多个矩形框（都是规范化矩形）
+    /*! 与依次调用 unionWith(boxes[i]) 的结果相同，宽或高小于长度容差的矩形框被忽略。\n
+        支持SSE时每个矩形框只需一次向量比较，用于计算大量图形的总范围。
+        \param count 矩形框个数
+        \param boxes 矩形框数组
+        \return 本矩形的引用，并集，规范化矩形
+    */
+    Box2d& unionWith(int count, const Box2d* boxes);
+    
+    //! 判断多个矩形框是否与本矩形框相交（都是规范化矩形）
+    /*! 与对每个矩形框调用 isIntersect() 的结果相同，结果按位存放，用于剔除显示区域外的图形。
+        \param count 矩形框个数
+        \param boxes 矩形框数组
+        \param mask 存放结果的数组，至少有 (count + 31) / 32 个元素，
+            第i个矩形框相交时 mask[i / 32] 的第 (i % 32) 位为1
+        \return 相交的矩形框个数
+    */
+    int intersectMask(int count, const Box2d* boxes, UInt32* mask) const;
+#endif
+    
     //! 合并一个点
     /*! 放大本矩形框以使得给定的点包含在本矩形框内，并使放大量最小
         \param x 要包含的点的X坐标
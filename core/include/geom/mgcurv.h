@@ -18,6 +18,30 @@
 */
 GEOMAPI void mgFitBezier(const Point2d* pts, float t, Point2d& fitpt);
 
+//! 计算三次贝塞尔曲线段折线化的最少等分段数
+/*! 按控制多边形的二阶差分(反映曲率)估计，等分为该段数后折线与曲线的距离不超过给定误差
+    \ingroup GEOMAPI_CURVE
+    \param[in] pts 4个点的数组，为贝塞尔曲线段的控制点
+    \param[in] tol 折线与曲线的最大允许距离，例如半个像素对应的长度
+    \return 等分段数，至少为1
+    \see mgFlattenBeziers
+*/
+GEOMAPI Int32 mgBezierSegments(const Point2d* pts, float tol);
+
+//! 将多段三次贝塞尔曲线自适应地转换为折线
+/*! 每段曲线按 mgBezierSegments 得到的段数等分参数，平直处只用一段
+    \ingroup GEOMAPI_CURVE
+    \param[in] count 控制点的个数，为3的倍数加1
+    \param[in] pts 控制点和端点的数组，相邻曲线段共用端点
+    \param[in] tol 折线与曲线的最大允许距离
+    \param[out] lines 折线顶点数组，为NULL时只计算顶点数
+    \param[in] maxCount lines 可容纳的顶点数，超出部分不写入
+    \return 折线顶点数，大于maxCount时应加大 lines 再调用
+    \see mgBezierSegments, MgFlattenCache
+*/
+GEOMAPI Int32 mgFlattenBeziers(Int32 count, const Point2d* pts, float tol, 
+                               Point2d* lines, Int32 maxCount);
+
 //! 用线上四点构成三次贝塞尔曲线段
 /*! 该贝塞尔曲线段的起点和终点为给定点，中间经过另外两个给定点，
     t=1/3过pt2, t=2/3过pt3。
@@ -0,0 +1,117 @@
+//! \file mgflatten.h
+//! \brief 定义贝塞尔曲线折线化缓存类 MgFlattenCache
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+
+#ifndef __GEOMETRY_FLATTENCACHE_H_
+#define __GEOMETRY_FLATTENCACHE_H_
+
+#include "mgcurv.h"
+#include <vector>
+#include <string.h>
+
+//! 贝塞尔曲线折线化缓存类
+/*! 按控制点内容和误差缓存 mgFlattenBeziers 的结果，在显示、剪裁和点中测试中
+    反复折线化同一曲线时直接取用。误差按 2^(k/2) 向下取整，相近的放缩比例共用结果。
+    一个缓存对象只能在一个线程中使用。
+    \ingroup GEOM_CLASS
+    \see mgFlattenBeziers
+*/
+class MgFlattenCache
+{
+public:
+    enum { kMaxEntries = 32 };          //!< 最多缓存的曲线数
+
+    MgFlattenCache() : m_clock(0) {}
+
+    //! 清除所有缓存
+    void clear() { m_entries.clear(); }
+
+    //! 返回多段三次贝塞尔曲线的折线顶点
+    /*!
+        \param[in] count 控制点的个数，为3的倍数加1
+        \param[in] pts 控制点和端点的数组
+        \param[in] tol 折线与曲线的最大允许距离
+        \param[out] n 折线顶点数
+        \return 折线顶点数组，在下次调用前有效，参数无效时为NULL
+    */
+    const Point2d* flatten(Int32 count, const Point2d* pts, float tol, Int32& n)
+    {
+        n = 0;
+        if (count < 4 || !pts || tol < _MGZERO)
+            return NULL;
+
+        tol = quantize(tol);
+        const UInt32 hash = hashPoints(count, pts);
+        Entry* entry = NULL;
+
+        for (size_t i = 0; i < m_entries.size(); i++)
+        {
+            Entry& e = m_entries[i];
+            if (e.hash == hash && e.count == count && e.tol == tol
+                && memcmp(pts, &e.pts.front(), count * sizeof(Point2d)) == 0)
+            {
+                e.used = ++m_clock;
+                n = (Int32)e.lines.size();
+                return &e.lines.front();
+            }
+            if (!entry || e.used < entry->used)
+                entry = &e;                     // 最久未用的
+        }
+        if (m_entries.size() < kMaxEntries)
+        {
+            m_entries.push_back(Entry());
+            entry = &m_entries.back();
+        }
+
+        entry->hash = hash;
+        entry->count = count;
+        entry->tol = tol;
+        entry->used = ++m_clock;
+        entry->pts.assign(pts, pts + count);
+        entry->lines.resize(mgFlattenBeziers(count, pts, tol, NULL, 0));
+        mgFlattenBeziers(count, pts, tol, &entry->lines.front(), (Int32)entry->lines.size());
+
+        n = (Int32)entry->lines.size();
+        return &entry->lines.front();
+    }
+
+private:
+    struct Entry {
+        UInt32      hash;               // 控制点的散列值
+        Int32       count;              // 控制点数
+        float       tol;                // 取整后的误差
+        UInt32      used;               // 最近使用的时刻
+        std::vector<Point2d> pts;       // 控制点，用于确认命中
+        std::vector<Point2d> lines;     // 折线顶点
+    };
+
+    // 误差向下取到 2^(k/2)，段数最多多出约19%
+    static float quantize(float tol)
+    {
+        int e;
+        float m = frexpf(tol, &e);      // tol = m * 2^e, m 在 [0.5, 1)
+        return ldexpf(m < 0.70710678f ? 0.5f : 0.70710678f, e);
+    }
+
+    // 按各坐标的32位内容做FNV-1a，UInt32 在64位系统上为8字节，不能用于按字读取
+    static UInt32 hashPoints(Int32 count, const Point2d* pts)
+    {
+        unsigned int h = 2166136261u;
+        for (Int32 i = 0; i < count; i++)
+        {
+            unsigned int x, y;
+            memcpy(&x, &pts[i].x, sizeof(x));
+            memcpy(&y, &pts[i].y, sizeof(y));
+            h = (h ^ x) * 16777619u;
+            h = (h ^ y) * 16777619u;
+        }
+        return h;
+    }
+
+private:
+    std::vector<Entry>  m_entries;
+    UInt32              m_clock;
+};
+
+#endif // __GEOMETRY_FLATTENCACHE_H_
@@ -267,6 +267,35 @@ GEOMAPI MgPtInAreaRet mgPtInArea(
     const Point2d& pt, Int32 count, const Point2d* vertexs, 
     Int32& order, const Tol& tol = Tol::gTol());
 
+//! 批量判断多个点是否在一多边形范围内
+/*! 按射线交点奇偶规则逐边处理所有点，不区分点在边上或与顶点重合的情况，
+    需要区分时用 mgPtInArea 。多边形顶点较多时自动按Y方向分段减少求交的边。
+    \ingroup GEOMAPI_LNREL
+    \param[in] n 测试点个数
+    \param[in] pts 测试点数组，元素个数为n
+    \param[in] count 多边形的顶点数
+    \param[in] vertexs 多边形的顶点数组
+    \param[out] inside 输出各点是否在多边形内，元素个数为n
+    \return 在多边形内的点数
+*/
+GEOMAPI Int32 mgPtsInArea(
+    Int32 n, const Point2d* pts, Int32 count, const Point2d* vertexs, bool* inside);
+
+//! 批量判断一点在多个多边形中的哪些范围内
+/*! 多个多边形的顶点连续存放在一个数组中，判断规则同 mgPtsInArea 。
+    \ingroup GEOMAPI_LNREL
+    \param[in] pt 给定的测试点
+    \param[in] polyCount 多边形个数
+    \param[in] starts 各多边形的起始顶点序号，元素个数为polyCount+1，最后一个为总顶点数
+    \param[in] vertexs 所有多边形的顶点数组
+    \param[in] extents 各多边形的包络框，用于快速排除，为NULL则忽略该参数
+    \param[out] inside 输出该点是否在各多边形内，元素个数为polyCount
+    \return 包含该点的多边形个数
+*/
+GEOMAPI Int32 mgPtInAreas(
+    const Point2d& pt, Int32 polyCount, const Int32* starts, 
+    const Point2d* vertexs, const Box2d* extents, bool* inside);
+
 //! 判断多边形是否为凸多边形
 /*!
     \ingroup GEOMAPI_LNREL
@@ -69,6 +69,40 @@ struct GiCanvasDrawing
 
     //! 在当前路径中添加闭合指令的原语函数
     virtual bool rawClosePath() = 0;
+
+    //! 批量绘制同一绘图参数的多条折线的原语函数，像素坐标，不剪裁
+    /*! 默认逐条调用 rawLines，派生类可重载为一次原生路径操作
+        \param ctx 绘图参数，所有折线共用
+        \param lineCount 折线条数
+        \param counts 各折线的顶点数，个数为lineCount
+        \param pxs 各折线的顶点依次相接的数组
+        \return 是否显示了至少一条折线
+    */
+    virtual bool rawLinesBatch(const GiContext* ctx, int lineCount, 
+        const int* counts, const Point2d* pxs)
+    {
+        bool ret = false;
+        for (int i = 0; i < lineCount; pxs += counts[i++])
+            ret = rawLines(ctx, pxs, counts[i]) || ret;
+        return ret;
+    }
+
+    //! 批量绘制同一绘图参数的多段贝塞尔曲线的原语函数，像素坐标，不剪裁
+    /*! 默认逐段调用 rawBeziers，派生类可重载为一次原生路径操作
+        \param ctx 绘图参数，所有曲线共用
+        \param curveCount 曲线条数，每条为一段或多段相接的贝塞尔曲线
+        \param counts 各曲线的控制点数，为3的倍数加1，个数为curveCount
+        \param pxs 各曲线的控制点依次相接的数组
+        \return 是否显示了至少一条曲线
+    */
+    virtual bool rawBeziersBatch(const GiContext* ctx, int curveCount, 
+        const int* counts, const Point2d* pxs)
+    {
+        bool ret = false;
+        for (int i = 0; i < curveCount; pxs += counts[i++])
+            ret = rawBeziers(ctx, pxs, counts[i]) || ret;
+        return ret;
+    }
 };
 
 #endif // __GEOMETRY_CANVAS_DRAWING_H_
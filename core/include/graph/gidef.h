@@ -6,20 +6,25 @@
 #ifndef __GEOMETRY_GIDEF_H_
 #define __GEOMETRY_GIDEF_H_
 
-#ifdef _MACOSX
-#include <libkern/OSAtomic.h>
-inline long giInterlockedIncrement(volatile long *p) { return OSAtomicIncrement32((volatile int32_t *)p); }
-inline long giInterlockedDecrement(volatile long *p) { return OSAtomicDecrement32((volatile int32_t *)p); }
-#elif !defined(_WIN32)
-inline long giInterlockedIncrement(volatile long *p) { return ++*p; }
-inline long giInterlockedDecrement(volatile long *p) { return --*p; }
-#else
+#if defined(_WIN32)
 #ifndef _WINDOWS_
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 #endif
 inline long giInterlockedIncrement(volatile long *p) { return InterlockedIncrement(p); }
 inline long giInterlockedDecrement(volatile long *p) { return InterlockedDecrement(p); }
+inline long giInterlockedExchange(volatile long *p, long value) { return InterlockedExchange(p, value); }
+inline long giInterlockedCompareExchange(volatile long *p, long value, long comparand)
+    { return InterlockedCompareExchange(p, value, comparand); }
+#elif defined(__GNUC__)     // GCC 和 clang (Linux, Android, Mac, iOS)，带完整内存屏障
+inline long giInterlockedIncrement(volatile long *p) { return __sync_add_and_fetch(p, 1L); }
+inline long giInterlockedDecrement(volatile long *p) { return __sync_sub_and_fetch(p, 1L); }
+inline long giInterlockedExchange(volatile long *p, long value)
+    { __sync_synchronize(); return __sync_lock_test_and_set(p, value); }
+inline long giInterlockedCompareExchange(volatile long *p, long value, long comparand)
+    { return __sync_val_compare_and_swap(p, comparand, value); }
+#else
+#error "giInterlockedIncrement is not implemented for this compiler"
 #endif
 
 //! 矢量路径节点类型
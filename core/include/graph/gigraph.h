@@ -10,6 +10,7 @@
 
 class GiGraphicsImpl;
 class GiCanvas;
+class GiDrawStats;
 
 //! 图形系统类
 /*! 本类用于显示各种图形，图元显示原语由外部的 GiCanvas 实现类来实现。
@@ -125,6 +126,18 @@ public:
     bool drawLines(const GiContext* ctx, 
         int count, const Point2d* points, bool modelUnit = true);
 
+    //! 批量绘制同一绘图参数的多条折线，模型坐标或世界坐标
+    /*! 全部在显示区域内的折线合并为一次 rawLinesBatch 调用，部分在显示区域内的折线逐条剪裁显示
+        \param ctx 绘图参数，忽略填充参数，为NULL时取为上一个绘图参数
+        \param lineCount 折线条数
+        \param counts 各折线的顶点数，个数为lineCount
+        \param points 各折线的顶点依次相接的数组
+        \param modelUnit 指定的坐标尺寸是模型坐标(true)还是世界坐标(false)
+        \return 是否显示了至少一条折线
+    */
+    bool drawLinesBatch(const GiContext* ctx, int lineCount, 
+        const int* counts, const Point2d* points, bool modelUnit = true);
+
     //! 绘制多条贝塞尔曲线，模型坐标或世界坐标
     /*! 第一条曲线从第一个点绘制到第四个点，以第二个点和第三个点为控制点。
         此序列中的每一条后续曲线都需要三个点：
@@ -297,6 +310,16 @@ public:
 #ifndef SWIG
     //! 返回当前绘图画布对象
     GiCanvas* getCanvas();
+
+    //! 设置每帧的绘图统计对象，为NULL时不统计
+    /*! 统计对象由调用者管理，在本对象使用期间须保持有效。
+        每次开始绘图时清零计数，结束绘图后可取出本帧的统计结果
+        \see GiDrawStats
+    */
+    void setStats(GiDrawStats* stats);
+
+    //! 返回绘图统计对象，未设置时为NULL
+    GiDrawStats* getStats() const;
     
     //! 返回坐标系管理对象
     GiTransform& _xf();
@@ -330,6 +353,8 @@ public:
     bool rawLineTo(float x, float y);
     bool rawBezierTo(const Point2d* pxs, int count);
     bool rawClosePath();
+    bool rawLinesBatch(const GiContext* ctx, int lineCount, const int* counts, const Point2d* pxs);
+    bool rawBeziersBatch(const GiContext* ctx, int curveCount, const int* counts, const Point2d* pxs);
 
 private:
     GiGraphics();
@@ -5,6 +5,10 @@
 
 #include "gigraph.h"
 #include "gicanvas.h"
+#include "gisync.h"
+#include "gistats.h"
+
+class PolygonClip;
 
 //! GiGraphics的内部实现类
 class GiGraphicsImpl
@@ -32,8 +36,10 @@ public:
     Box2d       rectDrawW;          //!< 剪裁矩形，世界坐标
     Box2d       rectDrawMaxM;       //!< 最大剪裁矩形，模型坐标
     Box2d       rectDrawMaxW;       //!< 最大剪裁矩形，世界坐标
+    PolygonClip* polygonClip;       //!< 多边形剪裁对象，保留剪裁缓冲
+    GiDrawStats* stats;             //!< 绘图统计对象，为NULL时不统计
 
-    GiGraphicsImpl(GiTransform* x) : xform(x), canvas(NULL)
+    GiGraphicsImpl(GiTransform* x) : xform(x), canvas(NULL), polygonClip(NULL), stats(NULL)
     {
         drawRefcnt = 0;
         drawColors = 0;
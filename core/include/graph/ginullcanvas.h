@@ -0,0 +1,221 @@
+//! \file ginullcanvas.h
+//! \brief 定义不显示的记录画布类 GiNullCanvas
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+
+#ifndef __GEOMETRY_NULLCANVAS_H_
+#define __GEOMETRY_NULLCANVAS_H_
+
+#include "gicanvas.h"
+#include "gigraph.h"
+#include <string.h>
+
+//! 不显示的记录画布类
+/*! 接受所有图元显示原语但不显示，只记下各原语的调用次数、顶点数和像素坐标范围，
+    用于单独测试 GiGraphics 和 MgShapes::draw 的坐标变换、剪裁和曲线计算耗时。\n
+    可选计算输出图元的校验和，坐标按 1/16 像素取整后参与计算，
+    以便在优化显示代码后检查输出的图形是否改变。批量原语按逐条原语记录，不影响校验和。
+    \ingroup GRAPH_INTERFACE
+*/
+class GiNullCanvas : public GiCanvas
+{
+public:
+    //! 图元显示原语的种类
+    enum Prim { kLine, kLines, kBeziers, kPolygon, kRect, kEllipse, kPath, kEndPath, kPrimCount };
+
+    //! 构造函数，设置为图形系统的画布
+    /*!
+        \param gs 图形系统对象，在本对象使用期间须保持有效
+        \param checksum 是否计算输出图元的校验和
+    */
+    GiNullCanvas(GiGraphics* gs, bool checksum = false) : m_checksum(checksum)
+    {
+        gs->_setCanvas(this);
+        reset();
+    }
+
+    //! 开始绘图，清除记录
+    /*!
+        \param clipBox 剪裁框，像素坐标，通常为显示窗口大小
+    */
+    void beginPaint(const RECT_2D& clipBox)
+    {
+        reset();
+        m_owner->_beginPaint(clipBox);
+    }
+
+    //! 结束绘图
+    void endPaint()
+    {
+        m_owner->_endPaint();
+    }
+
+    //! 清除记录
+    void reset()
+    {
+        memset(m_calls, 0, sizeof(m_calls));
+        m_vertexes = 0;
+        m_extent.empty();
+        m_hash = 2166136261u;
+    }
+
+    //! 设置是否计算输出图元的校验和
+    void setChecksum(bool checksum) { m_checksum = checksum; }
+
+    //! 返回指定原语的调用次数，路径按 rawEndPath 的次数计
+    long getCalls(Prim prim) const { return m_calls[prim]; }
+
+    //! 返回全部原语的调用次数
+    long getTotalCalls() const
+    {
+        long n = 0;
+        for (int i = 0; i < kPrimCount; i++)
+            n += m_calls[i];
+        return n;
+    }
+
+    //! 返回输出的顶点总数，矩形和椭圆按4个点计
+    long getVertexes() const { return m_vertexes; }
+
+    //! 返回输出图元的包络框，像素坐标，没有图元时为空框
+    const Box2d& getExtent() const { return m_extent; }
+
+    //! 返回输出图元的校验和，未设置计算校验和时不变
+    UInt32 getChecksum() const { return m_hash; }
+
+public:
+    void clearWindow() {}
+    bool drawCachedBitmap(float, float, bool) { return false; }
+    bool drawCachedBitmap2(const GiCanvas*, float, float, bool) { return false; }
+    void saveCachedBitmap(bool) {}
+    bool hasCachedBitmap(bool) const { return false; }
+    bool isBufferedDrawing() const { return false; }
+    int getCanvasType() const { return 0; }
+    const GiContext* getCurrentContext() const { return &m_context; }
+    void _clipBoxChanged(const RECT_2D&) {}
+    void _antiAliasModeChanged(bool) {}
+
+    void clearCachedBitmap(bool) {}
+    float getScreenDpi() const { return 96; }
+    GiColor getBkColor() const { return GiColor::White(); }
+    GiColor setBkColor(const GiColor& color) { return color; }
+
+    bool rawLine(const GiContext*, float x1, float y1, float x2, float y2)
+    {
+        begin(kLine);
+        add(x1, y1);
+        add(x2, y2);
+        return true;
+    }
+
+    bool rawLines(const GiContext*, const Point2d* pxs, int count)
+    {
+        begin(kLines);
+        addPoints(pxs, count);
+        return true;
+    }
+
+    bool rawBeziers(const GiContext*, const Point2d* pxs, int count)
+    {
+        begin(kBeziers);
+        addPoints(pxs, count);
+        return true;
+    }
+
+    bool rawPolygon(const GiContext*, const Point2d* pxs, int count)
+    {
+        begin(kPolygon);
+        addPoints(pxs, count);
+        return true;
+    }
+
+    bool rawRect(const GiContext*, float x, float y, float w, float h)
+    {
+        begin(kRect);
+        addBox(x, y, w, h);
+        return true;
+    }
+
+    bool rawEllipse(const GiContext*, float x, float y, float w, float h)
+    {
+        begin(kEllipse);
+        addBox(x, y, w, h);
+        return true;
+    }
+
+    bool rawPath(const GiContext*, int count, const Point2d* pxs, const UInt8* types)
+    {
+        begin(kPath);
+        addPoints(pxs, count);
+        for (int i = 0; m_checksum && i < count; i++)
+            hash(types[i]);
+        return true;
+    }
+
+    bool rawBeginPath() { return true; }
+    bool rawEndPath(const GiContext*, bool fill)
+    {
+        begin(kEndPath);
+        hash(fill ? 1 : 0);
+        return true;
+    }
+    bool rawMoveTo(float x, float y) { hash(1); add(x, y); return true; }
+    bool rawLineTo(float x, float y) { hash(2); add(x, y); return true; }
+    bool rawBezierTo(const Point2d* pxs, int count) { hash(3); addPoints(pxs, count); return true; }
+    bool rawClosePath() { hash(4); return true; }
+
+private:
+    void begin(Prim prim)
+    {
+        m_calls[prim]++;
+        hash(100 + prim);
+    }
+
+    void hash(Int32 value)
+    {
+        if (m_checksum) {
+            m_hash = ((m_hash ^ (UInt32)value) * 16777619u) & 0xFFFFFFFFu; // FNV-1a, UInt32 可能为64位
+        }
+    }
+
+    void add(float x, float y)
+    {
+        if (m_vertexes++ == 0) {                // 不用 unionWith，水平或竖直线的包络框也要合并
+            m_extent.set(x, y, x, y);
+        }
+        else {
+            m_extent.xmin = mgMin(m_extent.xmin, x);
+            m_extent.ymin = mgMin(m_extent.ymin, y);
+            m_extent.xmax = mgMax(m_extent.xmax, x);
+            m_extent.ymax = mgMax(m_extent.ymax, y);
+        }
+        if (m_checksum) {
+            hash((Int32)floorf(x * 16.f + 0.5f));
+            hash((Int32)floorf(y * 16.f + 0.5f));
+        }
+    }
+
+    void addPoints(const Point2d* pxs, int count)
+    {
+        for (int i = 0; i < count; i++)
+            add(pxs[i].x, pxs[i].y);
+    }
+
+    void addBox(float x, float y, float w, float h)
+    {
+        add(x, y);
+        add(x + w, y);
+        add(x + w, y + h);
+        add(x, y + h);
+    }
+
+private:
+    GiContext   m_context;
+    long        m_calls[kPrimCount];    // 各原语的调用次数
+    long        m_vertexes;             // 输出的顶点总数
+    Box2d       m_extent;               // 输出图元的包络框
+    UInt32      m_hash;                 // 校验和
+    bool        m_checksum;             // 是否计算校验和
+};
+
+#endif // __GEOMETRY_NULLCANVAS_H_
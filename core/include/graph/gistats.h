@@ -0,0 +1,306 @@
+//! \file gistats.h
+//! \brief 定义绘图统计类 GiDrawStats 和计时辅助类 GiStatsScope
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+
+#ifndef __GEOMETRY_GISTATS_H_
+#define __GEOMETRY_GISTATS_H_
+
+#include "gidef.h"
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/time.h>
+#endif
+
+//! 返回当前时刻，微秒，只用于计算时间差
+inline double giMicroseconds()
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart * 1e6 / (double)freq.QuadPart;
+#else
+    timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1e6 + tv.tv_usec;
+#endif
+}
+
+//! 每帧的绘图统计
+/*! 用 GiGraphics::setStats() 设置后，每次开始绘图时清零计数，在绘图过程中按图元种类
+    累计调用次数、剔除次数、变换、剪裁和丢弃的顶点数、到达画布的 raw 函数调用次数和耗时，
+    并记下最近各次调用的时间段，可导出为JSON或 Chrome 跟踪文件(chrome://tracing)。\n
+    未设置时 GiGraphics 的每个绘图函数只多一次空指针判断。不可在多个线程中同时使用。
+    \ingroup GRAPH_INTERFACE
+    \see GiStatsScope
+*/
+class GiDrawStats
+{
+public:
+    //! 图元种类
+    enum Kind {
+        kLine, kLines, kLinesBatch, kBeziers, kArc, kPolygon, kEllipse, kPie,
+        kRoundRect, kSplines, kBSplines, kPath, kShapes, kKindCount
+    };
+    enum { kMaxEvents = 100000 };       //!< 最多记下的时间段个数，超出时覆盖最早的
+
+    //! 一种图元的计数
+    struct Counter {
+        long    calls;          //!< 调用次数
+        long    culled;         //!< 未输出任何图元的调用次数，在显示区域外或参数无效
+        long    vertexes;       //!< 传入的顶点数
+        long    clipped;        //!< 部分在显示区域内而剪裁的顶点数
+        long    dropped;        //!< 与上一点相距不到2像素而丢弃的顶点数
+        long    rawCalls;       //!< 到达画布的 raw 函数调用次数
+        long    rawVertexes;    //!< 交给画布的顶点数
+        double  us;             //!< 累计耗时，微秒，包含嵌套调用的其他种类图元
+    };
+
+    //! 一次调用的时间段
+    struct Event {
+        int     kind;           //!< 图元种类，为 kKindCount 时表示一帧
+        int     depth;          //!< 嵌套层次
+        double  start;          //!< 开始时刻，微秒
+        double  us;             //!< 耗时，微秒
+    };
+
+    //! 进入计时范围时保存的状态，由 GiStatsScope 使用
+    struct Saved {
+        Kind    kind;
+        long    rawTotal;
+        double  start;
+    };
+
+    GiDrawStats() { reset(); }
+
+    //! 清除计数和记下的时间段
+    void reset()
+    {
+        m_events.clear();
+        m_eventNext = 0;
+        m_frames = 0;
+        m_origin = giMicroseconds();
+        m_frameStart = 0;
+        clearCounters();
+    }
+
+    //! 开始一帧，清除计数，由 GiGraphics 在开始绘图时调用
+    void beginFrame()
+    {
+        clearCounters();
+        m_frameStart = giMicroseconds();
+    }
+
+    //! 结束一帧，由 GiGraphics 在结束绘图时调用
+    void endFrame()
+    {
+        m_frameUs = giMicroseconds() - m_frameStart;
+        m_frames++;
+        addEvent(kKindCount, -1, m_frameStart, m_frameUs);
+    }
+
+    //! 返回已结束的帧数
+    long getFrames() const { return m_frames; }
+
+    //! 返回上一帧的耗时，微秒
+    double getFrameUs() const { return m_frameUs; }
+
+    //! 返回本帧中指定种类图元的计数
+    const Counter& counter(Kind kind) const { return m_counters[kind]; }
+
+    //! 返回本帧的图形个数、在显示区域外的图形个数和显示了的图形个数
+    void getShapes(long& total, long& culled, long& drawn) const
+    {
+        total = m_shapes[0];
+        culled = m_shapes[1];
+        drawn = m_shapes[2];
+    }
+
+    //! 返回图元种类的名称
+    static const char* kindName(int kind)
+    {
+        static const char* names[] = {
+            "line", "lines", "linesBatch", "beziers", "arc", "polygon", "ellipse", "pie",
+            "roundRect", "splines", "bsplines", "path", "shapes", "frame"
+        };
+        return kind >= 0 && kind <= kKindCount ? names[kind] : "";
+    }
+
+public:
+    //! 进入指定种类图元的计时范围
+    void enter(Kind kind, int vertexes, Saved& saved)
+    {
+        saved.kind = m_kind;
+        saved.rawTotal = m_rawTotal;
+        m_kind = kind;
+        m_depth++;
+        m_counters[kind].calls++;
+        m_counters[kind].vertexes += vertexes;
+        saved.start = giMicroseconds();
+    }
+
+    //! 退出计时范围
+    void leave(const Saved& saved)
+    {
+        double us = giMicroseconds() - saved.start;
+        Counter& c = m_counters[m_kind];
+
+        c.us += us;
+        if (m_rawTotal == saved.rawTotal)
+            c.culled++;
+        m_depth--;
+        addEvent(m_kind, m_depth, saved.start, us);
+        m_kind = saved.kind;
+    }
+
+    //! 累计当前种类图元传入的顶点数
+    void addVertexes(int n) { m_counters[m_kind].vertexes += n; }
+
+    //! 累计当前种类图元剪裁的顶点数
+    void addClipped(int n) { m_counters[m_kind].clipped += n; }
+
+    //! 累计当前种类图元因过近而丢弃的顶点数
+    void addDropped(int n) { m_counters[m_kind].dropped += n; }
+
+    //! 累计到达画布的 raw 函数调用，路径的各段只累计顶点数，calls 为0
+    void addRaw(int vertexes, int calls = 1)
+    {
+        m_counters[m_kind].rawCalls += calls;
+        m_counters[m_kind].rawVertexes += vertexes;
+        m_rawTotal += calls;
+    }
+
+    //! 累计图形个数，由 MgShapes::draw 调用
+    void addShapes(long total, long culled, long drawn)
+    {
+        m_shapes[0] += total;
+        m_shapes[1] += culled;
+        m_shapes[2] += drawn;
+    }
+
+public:
+    //! 导出本帧的计数，JSON格式，只含有调用过的图元种类
+    std::string toJson() const
+    {
+        std::string s;
+        char buf[256];
+
+        sprintf(buf, "{\"frames\":%ld,\"frameUs\":%.1f,"
+                "\"shapes\":{\"total\":%ld,\"culled\":%ld,\"drawn\":%ld},\"kinds\":{",
+                m_frames, m_frameUs, m_shapes[0], m_shapes[1], m_shapes[2]);
+        s = buf;
+        for (int i = 0, n = 0; i < kKindCount; i++) {
+            const Counter& c = m_counters[i];
+            if (c.calls == 0)
+                continue;
+            sprintf(buf, "%s\"%s\":{\"calls\":%ld,\"culled\":%ld,\"vertexes\":%ld,"
+                    "\"clipped\":%ld,\"dropped\":%ld,\"rawCalls\":%ld,\"rawVertexes\":%ld,"
+                    "\"us\":%.1f}", n++ ? "," : "", kindName(i), c.calls, c.culled,
+                    c.vertexes, c.clipped, c.dropped, c.rawCalls, c.rawVertexes, c.us);
+            s += buf;
+        }
+        s += "}}";
+        return s;
+    }
+
+    //! 导出记下的时间段，Chrome 跟踪文件格式，可在 chrome://tracing 中打开
+    std::string toTrace() const
+    {
+        std::string s("{\"traceEvents\":[");
+        char buf[160];
+
+        for (size_t i = 0; i < m_events.size(); i++) {
+            const Event& e = getEvent(i);
+            sprintf(buf, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\","
+                    "\"ts\":%.1f,\"dur\":%.1f,\"pid\":1,\"tid\":1}", i ? ",\n" : "\n",
+                    kindName(e.kind), e.kind == kKindCount ? "frame" : "draw",
+                    e.start - m_origin, e.us);
+            s += buf;
+        }
+        s += "\n]}\n";
+        return s;
+    }
+
+    //! 返回记下的时间段个数
+    size_t getEventCount() const { return m_events.size(); }
+
+    //! 返回记下的第 i 个时间段，按记下的先后，0 为最早的
+    const Event& getEvent(size_t i) const
+    {
+        return m_events[(m_eventNext + i) % m_events.size()];
+    }
+
+private:
+    void clearCounters()
+    {
+        memset(m_counters, 0, sizeof(m_counters));
+        m_shapes[0] = m_shapes[1] = m_shapes[2] = 0;
+        m_kind = kLine;
+        m_depth = 0;
+        m_rawTotal = 0;
+        m_frameUs = 0;
+    }
+
+    void addEvent(int kind, int depth, double start, double us)
+    {
+        Event e = { kind, depth, start, us };
+
+        if (m_events.size() < kMaxEvents) {
+            m_events.push_back(e);
+        }
+        else {                                  // 环形覆盖最早的，保留最近各帧的时间段
+            m_events[m_eventNext] = e;
+            m_eventNext = (m_eventNext + 1) % kMaxEvents;
+        }
+    }
+
+private:
+    Counter     m_counters[kKindCount]; // 各种图元的计数
+    long        m_shapes[3];            // 图形个数、在显示区域外的个数、显示了的个数
+    Kind        m_kind;                 // 当前图元种类
+    int         m_depth;                // 当前嵌套层次
+    long        m_rawTotal;             // 本帧 raw 函数调用次数
+    long        m_frames;               // 已结束的帧数
+    double      m_origin;               // 开始统计的时刻
+    double      m_frameStart;           // 本帧开始时刻
+    double      m_frameUs;              // 上一帧的耗时
+    std::vector<Event> m_events;        // 记下的时间段，满后为环形缓冲
+    size_t      m_eventNext;            // 满后下一个要覆盖的位置，即最早的时间段
+};
+
+//! 图元计时辅助类
+/*! 在绘图函数中定义局部变量，统计对象为NULL时不做任何事。
+    \ingroup GRAPH_INTERFACE
+*/
+class GiStatsScope
+{
+public:
+    //! 进入指定种类图元的计时范围
+    GiStatsScope(GiDrawStats* stats, GiDrawStats::Kind kind, int vertexes = 0)
+        : m_stats(stats)
+    {
+        if (stats)
+            stats->enter(kind, vertexes, m_saved);
+    }
+
+    //! 退出计时范围
+    ~GiStatsScope()
+    {
+        if (m_stats)
+            m_stats->leave(m_saved);
+    }
+
+private:
+    GiStatsScope(const GiStatsScope&);
+    void operator=(const GiStatsScope&);
+
+    GiDrawStats*        m_stats;
+    GiDrawStats::Saved  m_saved;
+};
+
+#endif // __GEOMETRY_GISTATS_H_
@@ -0,0 +1,140 @@
+//! \file gisync.h
+//! \brief 定义原子计数和线程同步类 GiMutex, GiMutexLock, GiSeqLock
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+
+#ifndef __GEOMETRY_GISYNC_H_
+#define __GEOMETRY_GISYNC_H_
+
+#include "gidef.h"
+
+#ifndef _WIN32
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+//! 原子读取计数，读到的是其他线程已发布的值
+inline long giAtomicLoad(const volatile long *p)
+{
+    return giInterlockedCompareExchange(const_cast<volatile long*>(p), 0, 0);
+}
+
+//! 等待其他线程时的退让，先忙等，再让出时间片，最后休眠
+/*!
+    \param spins 已等待的次数，从0开始逐次加1
+*/
+inline void giBackoff(int spins)
+{
+    if (spins < 16) {
+        return;                         // 忙等，临界区很短时最快
+    }
+#ifdef _WIN32
+    Sleep(spins < 32 ? 0 : 1);
+#else
+    if (spins < 32)
+        sched_yield();
+    else
+        usleep(1000);
+#endif
+}
+
+//! 先忙等后休眠的互斥锁
+/*! 临界区很短时在用户态忙等即可获得锁，长时间得不到锁时让出时间片再休眠，
+    不会长时间占用CPU。不可重入。
+    \ingroup GRAPH_INTERFACE
+    \see GiMutexLock
+*/
+class GiMutex
+{
+public:
+    GiMutex() : _state(0) {}
+
+    //! 尝试加锁，不等待
+    bool tryLock()
+    {
+        return giInterlockedCompareExchange(&_state, 1, 0) == 0;
+    }
+
+    //! 加锁，得不到锁时等待
+    void lock()
+    {
+        for (int spins = 0; !tryLock(); spins++)
+            giBackoff(spins);
+    }
+
+    //! 解锁
+    void unlock()
+    {
+        giInterlockedExchange(&_state, 0);
+    }
+
+private:
+    GiMutex(const GiMutex&);
+    void operator=(const GiMutex&);
+
+    volatile long   _state;             // 1 表示已加锁
+};
+
+//! 互斥锁的自动加锁解锁辅助类
+/*! \ingroup GRAPH_INTERFACE
+*/
+class GiMutexLock
+{
+public:
+    GiMutexLock(GiMutex& mutex) : _mutex(mutex) { _mutex.lock(); }
+    ~GiMutexLock() { _mutex.unlock(); }
+
+private:
+    GiMutexLock(const GiMutexLock&);
+    void operator=(const GiMutexLock&);
+
+    GiMutex&        _mutex;
+};
+
+//! 顺序锁，用于读多写少的状态
+/*! 写方在修改前后各调用 beginWrite() 和 endWrite()，多个写方须另外互斥。
+    读方不加锁，复制状态后用 retryRead() 检查期间是否被修改，是则重新读取：\code
+    long seq;
+    do {
+        seq = lock.beginRead();
+        copy = state;
+    } while (lock.retryRead(seq));
+    \endcode
+    \ingroup GRAPH_INTERFACE
+*/
+class GiSeqLock
+{
+public:
+    GiSeqLock() : _seq(0) {}
+
+    //! 开始修改状态，序号变为奇数
+    void beginWrite() { giInterlockedIncrement(&_seq); }
+
+    //! 结束修改状态，序号变为偶数
+    void endWrite() { giInterlockedIncrement(&_seq); }
+
+    //! 开始读取状态，等待正在进行的修改结束，返回当前序号
+    long beginRead() const
+    {
+        long seq = giAtomicLoad(&_seq);
+        for (int spins = 0; seq & 1; spins++) {
+            giBackoff(spins);
+            seq = giAtomicLoad(&_seq);
+        }
+        return seq;
+    }
+
+    //! 返回读取期间状态是否已被修改，需要重新读取
+    bool retryRead(long seq) const
+    {
+        return giAtomicLoad(&_seq) != seq;
+    }
+
+    //! 返回修改次数
+    long getChangeCount() const { return giAtomicLoad(&_seq) / 2; }
+
+private:
+    volatile long   _seq;               // 奇数表示正在修改
+};
+
+#endif // __GEOMETRY_GISYNC_H_
@@ -37,7 +37,8 @@ public:
     GiTransform(bool ydown = true);
 
     //! 拷贝构造函数
-    /*! 不复制 enableZoom 相应参数
+    /*! 不复制 enableZoom 相应参数。源对象可同时在另一线程中放缩，复制得到的是某次修改前后的一致状态，
+        例如在后台线程中显示时先复制视图的坐标系。
         \param src 源对象
     */
     GiTransform(const GiTransform& src);
@@ -46,7 +47,7 @@ public:
     ~GiTransform();
 
     //! 赋值函数
-    /*! 不复制 enableZoom 相应参数
+    /*! 不复制 enableZoom 相应参数。与拷贝构造函数一样，源对象可同时在另一线程中放缩
         \param src 源对象
         \return 本对象的引用
     */
@@ -164,6 +165,29 @@ public:
     Box2d setWorldLimits(const Box2d& rect);
 
     
+    //! 返回世界坐标原点的绝对坐标X
+    double getWorldOriginX() const;
+    
+    //! 返回世界坐标原点的绝对坐标Y
+    double getWorldOriginY() const;
+    
+    //! 设置世界坐标原点的绝对坐标，显示位置不变
+    /*! 世界坐标都是相对于该原点的单精度坐标，坐标值很大的图纸（例如地图）将原点设在图形附近，
+        图形坐标和显示窗口中心坐标都较小，放大显示时不损失精度。通常设为图形文档的原点，
+        见 MgShapes::getOriginX()。改变原点时显示窗口中心的世界坐标随之平移，显示极限范围不变。
+        \param x 原点的绝对坐标X
+        \param y 原点的绝对坐标Y
+    */
+    void setWorldOrigin(double x, double y);
+    
+    //! 绝对坐标转换为世界坐标
+    Point2d absoluteToWorld(double x, double y) const;
+    
+#ifndef SWIG
+    //! 世界坐标转换为绝对坐标
+    void worldToAbsolute(const Point2d& pntWorld, double& x, double& y) const;
+#endif
+    
     //! 开窗放大
     /*! 将给定的两点形成的矩形中的图形完全显示到显示窗口整个矩形中，
         并使放缩比例最小，且将给定的两点的中点处的图形位置平移到显示窗口的中心
@@ -7,6 +7,11 @@
 #define __GEOMETRY_BASICSHAPE_H_
 
 #include "mgshape.h"
+#include <vector>
+
+class MgSegmentIndex;
+class MgPackedPoints;
+class MgDecodeBuffer;
 
 //! 线段图形类
 /*! \ingroup GEOM_SHAPE
@@ -89,6 +94,9 @@ public:
     //! 设置是否为方形
     void setSquare(bool square) { setFlag(kMgSquare, square); }
 
+    //! 返回四个角点，不经过虚函数，用于按类型批量显示
+    const Point2d* getCorners() const { return _points; }
+
 protected:
     MgBaseRect();
     UInt32 _getPointCount() const;
@@ -221,6 +229,34 @@ public:
 
     //! 删除一个顶点
     bool removePoint(UInt32 index);
+    
+    //! 返回顶点数组，不经过虚函数，用于按类型批量显示，压缩存储时为NULL，可用 copyPoints() 解码
+    const Point2d* getPoints() const { return _points; }
+
+    //! 返回顶点数，不经过虚函数
+    UInt32 getCount() const { return _count; }
+    
+    //! 复制从 from 开始的 count 个顶点，压缩存储时直接解码，不恢复为浮点存储
+    UInt32 copyPoints(UInt32 from, UInt32 count, Point2d* points) const;
+    
+    //! 将顶点压缩为相对包络框中心的16位整数坐标，用于已完成的手绘笔画等顶点多的图形
+    /*! 每点由8字节降为4字节，样条曲线的切矢量也同样压缩，显示和点中测试时临时解码。
+        是有损压缩，误差约为包络框长边的1/131068，显示时因坐标略有变化，
+        相距很近而丢弃的顶点数可能与压缩前不同。修改顶点时自动恢复为浮点存储。
+        压缩后保存为按位紧凑排列的相邻点整数增量，读取时仍为压缩存储。
+        \return 是否已压缩，没有顶点时返回false
+    */
+    bool pack() { return _pack(); }
+    
+    //! 恢复为浮点存储
+    void unpack() { if (_packed) _unpack(); }
+    
+    //! 返回是否为压缩存储
+    bool isPacked() const { return _packed != NULL; }
+
+    //! 显示从顶点 from 到顶点 to 的部分，用于增量显示正在绘制的图形
+    bool drawPart(GiGraphics& gs, const GiContext& ctx, UInt32 from, UInt32 to) const {
+        return _drawPart(gs, ctx, from, to); }
 
 protected:
     MgBaseLines();
@@ -239,11 +275,20 @@ protected:
     bool _hitTestBox(const Box2d& rect) const;
     bool _save(MgStorage* s) const;
     bool _load(MgStorage* s);
+    const MgSegmentIndex* _getSegmentIndex() const;
+    virtual bool _drawPart(GiGraphics& gs, const GiContext& ctx, UInt32 from, UInt32 to) const;
+    virtual bool _pack();
+    virtual void _unpack();
+    
+    //! 返回顶点数组，压缩存储时解码到 buf 中
+    const Point2d* _pointsFor(MgDecodeBuffer& buf) const;
 
 protected:
-    Point2d*    _points;
-    UInt32      _maxCount;
-    UInt32      _count;
+    Point2d*            _points;        //!< 顶点数组，压缩存储时为NULL
+    UInt32              _maxCount;
+    UInt32              _count;
+    mutable MgSegmentIndex* volatile _segIndex; //!< 顶点很多时在第一次点中时建立的线段索引
+    MgPackedPoints*     _packed;        //!< 压缩存储的顶点，浮点存储时为NULL
 };
 
 //! 折线图形类
@@ -269,10 +314,18 @@ protected:
     void _update();
     float _hitTest(const Point2d& pt, float tol, Point2d& nearpt, Int32& segment) const;
     bool _hitTestBox(const Box2d& rect) const;
+    bool _drawPart(GiGraphics& gs, const GiContext& ctx, UInt32 from, UInt32 to) const;
+    bool _pack();
+    void _unpack();
+    void _packKnots(const Vector2d* knotvs);
+    
+    //! 返回切矢量数组，压缩存储时解码到 buf 中，压缩的切矢量与顶点数不符时按 points 计算
+    const Vector2d* _knotvsFor(const Point2d* points, MgDecodeBuffer& buf) const;
 
 protected:
-    Vector2d*   _knotvs;
-    UInt32      _bzcount;
+    Vector2d*           _knotvs;        //!< 切矢量数组，压缩存储时为NULL
+    UInt32              _bzcount;
+    MgPackedPoints*     _packedKnots;   //!< 压缩存储的切矢量，在压缩或 update() 时生成
 };
 
 //! 矩形图形基类
@@ -36,6 +36,33 @@ void mgRegisterCommand(const char* name, MgCommand* (*factory)());
 */
 void mgRegisterShapeCreator(UInt32 type, MgShape* (*factory)());
 
+#ifndef SWIG
+//! 在插件库中自动注册图形类型的辅助类
+/*! 在插件库中定义该类的静态变量，库加载时注册，卸载时取消注册：\code
+    static MgShapeRegistrar<MgShapeT<YourShape> > s_yourShape;
+    \endcode
+    注册表查找不加锁，注册后不影响 mgCreateShape 的速度。
+    \ingroup GEOM_SHAPE
+*/
+template <class ShapeT>
+struct MgShapeRegistrar {
+    MgShapeRegistrar() { mgRegisterShapeCreator(ShapeT::Type(), ShapeT::create); }
+    ~MgShapeRegistrar() { mgRegisterShapeCreator(ShapeT::Type(), NULL); }
+};
+
+//! 在插件库中自动注册命令的辅助类
+/*! 在插件库中定义该类的静态变量，库加载时注册，卸载时取消注册：\code
+    static MgCommandRegistrar<YourCmd> s_yourCmd;
+    \endcode
+    \ingroup GEOM_SHAPE
+*/
+template <class CmdT>
+struct MgCommandRegistrar {
+    MgCommandRegistrar() { mgRegisterCommand(CmdT::Name(), CmdT::Create); }
+    ~MgCommandRegistrar() { mgRegisterCommand(CmdT::Name(), NULL); }
+};
+#endif // SWIG
+
 //! 图形视图接口
 /*! \ingroup GEOM_SHAPE
     \interface MgView
@@ -112,6 +139,10 @@ struct MgCommand {
     virtual bool touchMoved(const MgMotion* sender) = 0;    //!< 正在滑动
     virtual bool touchEnded(const MgMotion* sender) = 0;    //!< 滑动结束
     virtual bool mouseHover(const MgMotion*) { return false; }; //!< 鼠标掠过
+    
+    //! 一个显示帧内的多个滑动点，sender 为最后一点，points 为依次经过的模型坐标点
+    virtual bool touchMovedPoints(const MgMotion* sender, UInt32, const Point2d*) {
+        return touchMoved(sender); }
 };
 
 //! 命令接口的默认实现，可以以此派生新命令类
@@ -53,11 +53,25 @@ protected:
     MgShape* dynshape() { return m_shape; }
     Point2d snapPoint(const MgMotion* sender, bool firstStep = false);
     
+    //! 返回正在绘制的折线类图形中已不再变化的顶点数，大于1时可增量显示
+    /*! 增量显示时已固定部分保存在画布的第二个后备缓冲位图中，每帧只补画新增的固定段，
+        再画后面的动态部分；顶点被改动(如撤销)时自动完整重画。默认返回0不增量显示。
+     */
+    virtual UInt32 getFixedCount() { return 0; }
+    
+private:
+    bool drawIncremental(const MgMotion* sender, GiGraphics* gs, UInt32 fixed);
+    
 protected:
     UInt32      m_step;
 private:
     MgShape*    m_shape;
     bool        m_needClear;
+    UInt32      m_cachedCount;      // 已保存到第二个后备缓冲位图的顶点数
+    Point2d     m_cachedEnd;        // 已保存部分的末顶点
+    GiCanvas*   m_cachedCanvas;     // 保存位图的画布，放大镜等视图各有画布
+    Matrix2d    m_cachedXf;         // 保存时的模型到显示坐标变换，平移或放缩后失效
+    UInt32      m_cachedChanges;    // 保存时图形列表的改变计数，位图中含有其他图形
 };
 
 #endif // __GEOMETRY_MGCOMMAND_DRAW_H_
@@ -0,0 +1,134 @@
+//! \file mginput.h
+//! \brief 定义触笔输入缓冲类 MgInputQueue
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+
+#ifndef __GEOMETRY_MGINPUTQUEUE_H_
+#define __GEOMETRY_MGINPUTQUEUE_H_
+
+#include "mgcmd.h"
+#include <gisync.h>
+#include <vector>
+
+//! 触笔输入缓冲类
+/*! 平台视图在输入事件中调用 push() 放入原始采样点，在每个显示帧中调用 flush()
+    取出积累的点，按最小像素距离过滤后一次交给命令的 touchMovedPoints() 处理，
+    避免高采样率的触笔每个事件都重新显示。\n
+    只允许一个线程调用 push()，另一个线程调用 reset() 和 flush()，不需要加锁。
+    \ingroup GEOM_SHAPE
+*/
+class MgInputQueue
+{
+public:
+    enum { kCapacity = 256 };           //!< 缓冲的采样点数，为2的幂
+
+    MgInputQueue() : _head(0), _tail(0), _minDist(1.f), _predict(false), _frameMs(0)
+    {
+        _last.ms = 0;
+    }
+
+    //! 设置过滤距离和是否预测
+    /*!
+        \param minPixels 与上一个保留点的距离小于此像素数的采样点将被忽略
+        \param predict 是否按当前速度预测一帧后的位置，作为命令的当前点
+    */
+    void setOptions(float minPixels, bool predict)
+    {
+        _minDist = minPixels;
+        _predict = predict;
+    }
+
+    //! 开始滑动时丢弃未处理的采样点，由显示线程在 touchBegan 时调用
+    /*!
+        \param point 开始点，视图坐标
+        \param ms 开始时刻，毫秒
+    */
+    void reset(const Point2d& point, float ms)
+    {
+        _tail = _head;
+        _last.point = point;
+        _last.ms = ms;
+        _kept = point;
+        _frameMs = 0;
+    }
+
+    //! 放入一个原始采样点，可在输入线程中调用
+    /*!
+        \param point 采样点，视图坐标
+        \param ms 采样时刻，毫秒
+        \return 是否放入，缓冲满时丢弃该点
+    */
+    bool push(const Point2d& point, float ms)
+    {
+        long head = _head;
+
+        if (head - giAtomicLoad(&_tail) >= kCapacity)
+            return false;
+        _samples[head & (kCapacity - 1)].point = point;
+        _samples[head & (kCapacity - 1)].ms = ms;
+        giInterlockedIncrement(&_head);     // 写好采样点后再发布
+        return true;
+    }
+
+    //! 返回是否有未处理的采样点
+    bool empty() const
+    {
+        return giAtomicLoad(&_head) == _tail;
+    }
+
+    //! 在显示帧中处理积累的采样点
+    /*!
+        \param motion 平台视图的滑动参数，将更新其当前点、上次点和速度
+        \param cmd 当前命令，为NULL时只更新 motion
+        \return 命令是否处理了滑动，没有新的保留点时返回false
+    */
+    bool flush(MgMotion* motion, MgCommand* cmd)
+    {
+        const Matrix2d& d2m = motion->view->xform()->displayToModel();
+        const Sample start (_last);
+        const long head = giAtomicLoad(&_head);
+
+        _points.clear();
+        for (; _tail != head; giInterlockedIncrement(&_tail)) {
+            _last = _samples[_tail & (kCapacity - 1)];
+            if (_last.point.distanceTo(_kept) >= _minDist) {
+                _kept = _last.point;
+                _points.push_back(_kept * d2m);
+            }
+        }
+        if (_points.empty())
+            return false;
+
+        float ms = _last.ms - start.ms;
+        Vector2d speed (ms > 0 ? (_last.point - start.point) / ms : Vector2d());
+
+        motion->lastPoint = motion->point;
+        motion->lastPointM = motion->pointM;
+        motion->velocity = speed.length() * 1000.f;
+        motion->point = _kept;
+        if (_predict && _frameMs > 0)       // 按速度外推一帧
+            motion->point += speed * _frameMs;
+        motion->pointM = motion->point * d2m;
+        _frameMs = ms;
+
+        return cmd && cmd->touchMovedPoints(motion, (UInt32)_points.size(), &_points.front());
+    }
+
+private:
+    struct Sample {
+        Point2d     point;              // 视图坐标
+        float       ms;                 // 采样时刻，毫秒
+    };
+
+    Sample          _samples[kCapacity];    // 环形缓冲
+    volatile long   _head;              // 输入线程写入位置
+    volatile long   _tail;              // 显示线程读取位置
+    float           _minDist;           // 过滤距离，像素
+    bool            _predict;           // 是否预测一帧后的位置
+    float           _frameMs;           // 上一帧的采样时长，毫秒
+    Sample          _last;              // 最近处理的采样点
+    Point2d         _kept;              // 最近保留的采样点
+    std::vector<Point2d> _points;       // 本帧保留的采样点，模型坐标
+};
+
+#endif // __GEOMETRY_MGINPUTQUEUE_H_
@@ -152,9 +152,13 @@ public:
     //! 设置图形特征标志位
     virtual void setFlag(MgShapeBit bit, bool on);
     
+    //! 返回 update() 和改变标志位的次数，用于检查图形是否改变，复制图形时不复制
+    UInt32 getChangeCount() const { return _changeCount; }
+    
 protected:
     Box2d   _extent;
     UInt32  _flags;
+    UInt32  _changeCount;
 
 protected:
     bool _isClosed() const { return getFlag(kMgClosed); }
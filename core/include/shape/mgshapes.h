@@ -9,6 +9,7 @@
 #include <mgshape.h>
 
 class MgLockRW;
+class GiTransform;
 
 //! 图形列表接口
 /*! \ingroup GEOM_SHAPE
@@ -27,16 +28,69 @@ struct MgShapes : public MgObject
     virtual MgShape* getLastShape() const = 0;
     virtual MgShape* findShape(UInt32 nID) const = 0;
     virtual MgShape* findShapeByTag(UInt32 tag) const = 0;
+    
+    //! 按图形索引查找给定类型的图形，只载入这些延迟载入的图形，返回找到的个数
+    /*!
+        \param type 图形类型，即 MgShape::getType()，例如 10000 + MgGrid::Type()
+        \param count shapes 的元素个数，为0时只返回个数
+        \param shapes 填充找到的图形，可为NULL
+    */
+    virtual UInt32 findShapesByType(UInt32 type, UInt32 count, MgShape** shapes) const = 0;
+    
+    //! 按图形索引查找范围与给定矩形相交的图形，不载入延迟载入的图形，返回找到的个数
+    /*! 可先用范围剔除，再用 findShape() 只载入需要的图形。载入失败的图形不会找到。
+        \param box 模型坐标矩形，为空矩形 Box2d() 时查找所有图形
+        \param count ids 和 extents 的元素个数，为0时只返回个数
+        \param ids 按图形顺序填充图形ID，可为NULL
+        \param extents 填充图形范围，未载入的图形为文档中记下的范围，可为NULL
+    */
+    virtual UInt32 findShapeExtents(const Box2d& box, UInt32 count,
+                                    UInt32* ids, Box2d* extents) const = 0;
     virtual Box2d getExtent() const = 0;
     
     virtual MgShape* hitTest(const Box2d& limits, Point2d& nearpt, Int32& segment) const = 0;
     virtual int draw(GiGraphics& gs, const GiContext *ctx = NULL) const = 0;
     virtual UInt32 getChangeCount() = 0;
     virtual void afterChanged() = 0;
+    
+    //! 通知一个图形的形状或属性已改变，只更新该图形的索引项和文档范围
+    /*! 在 MgShapesLock::Modify 锁定期间修改图形后调用，解锁时不再重新生成整个图形索引，
+        文档范围只在边界上的图形缩小时才重新计算。\n
+        shape 为NULL表示增删改都已通知，只增加改变次数，由 MgShapesLock 在解锁时调用。
+    */
+    virtual void afterShapeChanged(MgShape* shape) = 0;
     virtual bool save(MgStorage* s, UInt32 startIndex = 0) const = 0;
     virtual bool load(MgStorage* s, bool addOnly = false) = 0;
     
-    //! 删除所有图形
+    //! 延迟载入图形，只读出各图形的类型、ID和范围，在显示、点中或查找到时才载入图形内容
+    /*! 存取对象须保持有效并能按序号重新读取节点，直到图形全部载入或调用 clear()、load() 为止。
+        每次载入图形时从调用本函数时的当前节点重新进入文档节点，存取对象不能停留在其他节点。\n
+        可在读锁定期间的多个线程中载入，各次载入依次进行。载入失败的图形不显示，
+        不能点中和查找，也不能遍历到，保存时跳过。
+    */
+    virtual bool loadLazily(MgStorage* s) = 0;
+    
+    //! 开始记录图形增删改，以当前已载入的图形为基准
+    /*! 开始记录后载入文档时也记下各图形的基准，未开始记录时载入文档不必计算基准。
+        未调用本函数时，第一次 saveJournal() 写出所有已载入的图形，此后自动记录。
+    */
+    virtual void beginJournal() = 0;
+    
+    //! 追加保存自上次追加保存或压缩以来的图形增删改记录，返回记录数，失败时返回-1
+    /*! 每次调用写入一个 "journal" 节点，序号依次递增，由调用者追加到文档末尾。
+        只比较各图形的对象、改变次数和绘图属性，有不同时才比较保存内容，不必每次序列化所有图形。
+        文档变换、显示比例、中心点、原点或图形顺序改变时在记录节点中写出 "doc" 节点。
+        改变原点时所有图形都已平移，都写出修改记录，可改用 compactJournal() 压缩。
+    */
+    virtual int saveJournal(MgStorage* s) = 0;
+    
+    //! 在已载入的文档上依次应用追加保存的增删改记录，未开始记录时自动开始记录
+    virtual bool loadJournal(MgStorage* s) = 0;
+    
+    //! 保存整个文档作为新的基准文档，此后的追加记录序号从0开始
+    virtual bool compactJournal(MgStorage* s) = 0;
+    
+    //! 删除所有图形，文档原点恢复为0
     virtual void clear() = 0;
     
     //! 复制出新图形并添加到图形列表中
@@ -60,6 +114,21 @@ struct MgShapes : public MgObject
     //! 设置视图放缩比例和位置
     virtual void setZoomState(float scale, const Point2d& centerW) = 0;
     
+    //! 返回文档原点的绝对坐标X，图形坐标是相对于文档原点的单精度坐标
+    virtual double getOriginX() const = 0;
+    
+    //! 返回文档原点的绝对坐标Y
+    virtual double getOriginY() const = 0;
+    
+    //! 设置文档原点的绝对坐标，平移各图形使其绝对位置不变，用于坐标值很大的图纸
+    /*! 图形按单精度平移，实际的原点为原来的原点减去平移量，可能与给定值略有差别。
+        改变后调用 applyOrigin() 使显示的原点相同
+    */
+    virtual void setOrigin(double x, double y) = 0;
+    
+    //! 将坐标系的世界坐标原点设为文档原点，在载入文档或改变原点后、显示前调用
+    virtual void applyOrigin(GiTransform& xf) const = 0;
+    
     //! 得到锁定数据对象以便读写锁定
     virtual MgLockRW* getLockData() = 0;
 };
@@ -98,7 +167,9 @@ class MgShapesLock
     int         m_mode;
 public:
     MgShapes*   shapes;
-    enum { ReadOnly = 0, Add = 0x1, Edit = 0x3, Unknown = 99 };
+    //! 锁定方式，Add 只添加图形，Modify 还修改图形并逐个调用 MgShapes::afterShapeChanged()，
+    //! 这两种方式解锁时增量更新图形索引，Edit 为任意修改
+    enum { ReadOnly = 0, Add = 0x1, Edit = 0x3, Modify = 0x5, Unknown = 99 };
     MgShapesLock(MgShapes* sp, int flags, int timeout = 200);
     ~MgShapesLock();
     
@@ -7,11 +7,52 @@
 #define __GEOMETRY_MGSHAPES_TEMPL_H_
 
 #include <mgshapes.h>
+#include <mgshapet.h>
+#include <mgbasicsp.h>
 #include <mgstorage.h>
 #include <gigraph.h>
+#include <gisync.h>
+#include <gistats.h>
+#include <map>
+#include <vector>
+#include <algorithm>
 
 MgShape* mgCreateShape(UInt32 type);
 
+//! 计算所写入内容的散列值的存取类，用于检查图形是否改变
+/*! \ingroup GEOM_SHAPE
+*/
+class MgHashStorage : public MgStorage
+{
+public:
+    UInt32  hash;
+    
+    MgHashStorage() : hash(2166136261UL) {}
+    
+    bool readNode(const char*, int, bool) { return false; }
+    bool readBool(const char*, bool defvalue) { return defvalue; }
+    float readFloat(const char*, float defvalue) { return defvalue; }
+    int readFloatArray(const char*, float*, int) { return 0; }
+    int readString(const char*, wchar_t*, int) { return 0; }
+    
+    bool writeNode(const char*, int index, bool ended) {
+        add(&index, sizeof(index)); add(&ended, sizeof(ended)); return true; }
+    void writeBool(const char*, bool value) { add(&value, sizeof(value)); }
+    void writeFloat(const char*, float value) { add(&value, sizeof(value)); }
+    void writeFloatArray(const char*, const float* values, int count) {
+        add(values, count * sizeof(float)); }
+    void writeString(const char*, const wchar_t* value) {
+        for (; value && *value; value++) add(value, sizeof(wchar_t)); }
+    
+protected:
+    void writeInt(const char*, int value) { add(&value, sizeof(value)); }
+    
+    void add(const void* data, int size) {      // FNV-1a
+        for (const UInt8* p = (const UInt8*)data; size > 0; size--, p++)
+            hash = (hash ^ *p) * 16777619UL;
+    }
+};
+
 //! 图形列表模板类
 /*! \ingroup GEOM_SHAPE
     \param Container 包含(MgShape*)的vector、list等容器类型
@@ -23,9 +64,111 @@ class MgShapesT : public MgShapes
     typedef MgShapesT<Container, ContextT> ThisClass;
     typedef typename Container::const_iterator const_iterator;
     typedef typename Container::iterator iterator;
+    
+    //! 按图形顺序排列的图形范围、类型和ID的并行数组，用于连续扫描剔除和查找
+    /*! 在读锁定期间可能由多个线程同时重新生成，由 _lazyMutex 互斥，两个有效标志用原子操作读取和发布。
+    */
+    struct ShapeIndex {
+        std::vector<Box2d>      extents;
+        std::vector<UInt32>     types;
+        std::vector<UInt32>     ids;
+        std::vector<MgShape*>   shapes;
+        std::vector<int>        slots;      //!< 按图形地址散列的开放寻址表，存放数组序号，空位为-1
+        std::vector<int>        idSlots;    //!< 按图形ID散列的开放寻址表，与 slots 等长
+        UInt32                  maxID;      //!< 最大的图形ID
+        Box2d                   extent;     //!< 文档范围，各图形范围的并集
+        volatile long           extentValid; //!< 文档范围是否有效，边界上的图形缩小或移除后失效
+        volatile long           valid;
+        
+        ShapeIndex() : maxID(0), extentValid(1), valid(0) {}
+        void clear() {
+            extents.clear(); types.clear(); ids.clear(); shapes.clear();
+            slots.clear();
+            idSlots.clear();
+            maxID = 0;
+            extent.empty();
+            extentValid = 1;
+            valid = 0;
+        }
+        void add(MgShape* shape, const Box2d& ext) {
+            extents.push_back(ext);
+            types.push_back(shape->getType());
+            ids.push_back(shape->getID());
+            maxID = mgMax(maxID, shape->getID());
+            shapes.push_back(shape);
+            extent.unionWith(ext);
+            if (slots.size() < shapes.size() * 2)
+                rehash();
+            else
+                insertSlot((int)shapes.size() - 1);
+        }
+        int find(const MgShape* shape) const {
+            if (slots.empty())
+                return -1;
+            const size_t mask = slots.size() - 1;
+            for (size_t h = hashOf((size_t)shape >> 3) & mask; slots[h] >= 0; h = (h + 1) & mask) {
+                if (shapes[slots[h]] == shape)
+                    return slots[h];
+            }
+            return -1;
+        }
+        int findID(UInt32 id) const {       // 有相同ID时返回先添加的
+            if (idSlots.empty())
+                return -1;
+            const size_t mask = idSlots.size() - 1;
+            for (size_t h = hashOf(id) & mask; idSlots[h] >= 0; h = (h + 1) & mask) {
+                if (ids[idSlots[h]] == id)
+                    return idSlots[h];
+            }
+            return -1;
+        }
+        void remove(int i) {
+            shrinkExtent(extents[i]);
+            extents.erase(extents.begin() + i);
+            types.erase(types.begin() + i);
+            ids.erase(ids.begin() + i);
+            shapes.erase(shapes.begin() + i);
+            rehash();                       // 后面的序号都变了，与数组移动同为O(n)
+        }
+        static size_t hashOf(size_t key) {
+            return (size_t)(key * 2654435761UL);
+        }
+        void insertSlot(int i) {
+            const size_t mask = slots.size() - 1;
+            size_t h = hashOf((size_t)shapes[i] >> 3) & mask;
+            while (slots[h] >= 0)
+                h = (h + 1) & mask;
+            slots[h] = i;
+            for (h = hashOf(ids[i]) & mask; idSlots[h] >= 0; h = (h + 1) & mask) ;
+            idSlots[h] = i;
+        }
+        void rehash() {                     // 表长为2的幂，至少是图形数的两倍
+            size_t n = 16;
+            while (n < shapes.size() * 2)
+                n *= 2;
+            slots.assign(n, -1);
+            idSlots.assign(n, -1);
+            for (size_t i = 0; i < shapes.size(); i++)
+                insertSlot((int)i);
+        }
+        void update(int i, const Box2d& ext) {
+            if (!ext.contains(extents[i]))
+                shrinkExtent(extents[i]);
+            extent.unionWith(ext);
+            extents[i] = ext;
+        }
+        //! 图形原来的范围在文档范围的边界上时，文档范围可能缩小，需重新计算
+        void shrinkExtent(const Box2d& old) {
+            if (!(old.xmin > extent.xmin && old.ymin > extent.ymin
+                  && old.xmax < extent.xmax && old.ymax < extent.ymax)) {
+                extentValid = 0;
+            }
+        }
+    };
 public:
     MgShapesT(bool hasContext = true) : _context(hasContext ? new ContextT() : NULL)
-        , _scale(1), _changeCount(0)
+        , _scale(1), _originX(0), _originY(0), _changeCount(0), _lazyStorage(NULL), _lazyCount(0)
+        , _journalCount(0), _journaling(false), _drawByType(false)
     {
     }
 
@@ -82,6 +225,16 @@ public:
         for (; it != _shapes.end(); ++it)
             (*it)->release();
         _shapes.clear();
+        _lazyShapes.clear();
+        _lazyStorage = NULL;
+        _lazyCount = 0;
+        _savedStates.clear();
+        _savedOrder.clear();
+        _journalCount = 0;
+        _originX = 0;
+        _originY = 0;
+        _index.clear();
+        giInterlockedIncrement(&_changeCount);  // 缓存了图形指针的调用者据此失效
     }
 
     MgShape* addShape(const MgShape& src)
@@ -91,6 +244,8 @@ public:
         {
             p->setParent(this, getNewID(src.getID()));
             _shapes.push_back(p);
+            if (_index.valid)
+                _index.add(p, p->shapec()->getExtent());
         }
         return p;
     }
@@ -101,7 +256,13 @@ public:
         {
             MgShape* shape = *it;
             if (shape->getID() == nID) {
+                if (!loadLazyShape(shape))          // 载入失败的图形移出后不能留在延迟载入表中
+                    forgetLazyShape(shape);
                 _shapes.erase(it);
+                int i = _index.valid ? _index.find(shape) : -1;
+                if (i >= 0)
+                    _index.remove(i);
+                giInterlockedIncrement(&_changeCount);
                 return shape;
             }
         }
@@ -121,8 +282,9 @@ public:
 
     MgShape* getFirstShape(void*& it) const
     {
-        it = (void*)(new const_iterator(_shapes.begin()));
-        return _shapes.empty() ? NULL : _shapes.front();
+        const_iterator* pit = new const_iterator(_shapes.begin());
+        it = (void*)pit;
+        return loadFrom(*pit);
     }
     
     MgShape* getNextShape(void*& it) const
@@ -130,71 +292,121 @@ public:
         const_iterator* pit = (const_iterator*)it;
         if (pit && *pit != _shapes.end()) {
             ++(*pit);
-            if (*pit != _shapes.end())
-                return *(*pit);
+            return loadFrom(*pit);
         }
         return NULL;
     }
     
     MgShape* getLastShape() const
     {
-        return _shapes.empty() ? NULL : _shapes.back();
+        typename Container::const_reverse_iterator it = _shapes.rbegin();
+        for (; it != _shapes.rend(); ++it) {
+            MgShape* shape = loadLazyShape(*it);
+            if (shape)
+                return shape;
+        }
+        return NULL;
     }
 
     MgShape* findShape(UInt32 nID) const
     {
-        for (const_iterator it = _shapes.begin(); it != _shapes.end(); ++it)
-        {
-            if ((*it)->getID() == nID)
-                return *it;
-        }
-        return NULL;
+        return loadLazyShape(findShapeNoLoad(nID));
     }
 
     MgShape* findShapeByTag(UInt32 tag) const
     {
         for (const_iterator it = _shapes.begin(); it != _shapes.end(); ++it)
         {
-            if ((*it)->getTag() == tag)
-                return *it;
+            MgShape* shape = loadLazyShape(*it);
+            if (shape && shape->getTag() == tag)
+                return shape;
         }
         return NULL;
     }
+    
+    UInt32 findShapesByType(UInt32 type, UInt32 count, MgShape** shapes) const
+    {
+        const ShapeIndex& index = getIndex();
+        UInt32 n = 0;
+        
+        for (size_t i = 0; i < index.types.size(); i++) {
+            if (index.types[i] == type && loadLazyShape(index.shapes[i])) {
+                if (shapes && n < count)
+                    shapes[n] = index.shapes[i];
+                n++;
+            }
+        }
+        return n;
+    }
+    
+    UInt32 findShapeExtents(const Box2d& box, UInt32 count, UInt32* ids, Box2d* extents) const
+    {
+        const ShapeIndex& index = getIndex();
+        const bool all = box.isNull();
+        UInt32 n = 0;
+        
+        for (size_t i = 0; i < index.extents.size(); i++) {
+            const Box2d& extent = index.extents[i];
+            if (all ? (extent.isNull() && isLazyFailed(index.shapes[i]))
+                : !extent.isIntersect(box)) {
+                continue;
+            }
+            if (n < count) {
+                if (ids)
+                    ids[n] = index.ids[i];
+                if (extents)
+                    extents[n] = extent;
+            }
+            n++;
+        }
+        return n;
+    }
 
     Box2d getExtent() const
     {
-        Box2d extent;
-        for (const_iterator it = _shapes.begin(); it != _shapes.end(); ++it)
-        {
-            extent.unionWith((*it)->shape()->getExtent());
+        const ShapeIndex& index = getIndex();
+        
+        if (!giAtomicLoad(&index.extentValid)) {
+            GiMutexLock locker(_lazyMutex);
+            if (!_index.extentValid) {
+                Box2d extent;
+                if (!index.extents.empty())
+                    extent.unionWith((int)index.extents.size(), &index.extents.front());
+                _index.extent = extent;
+                giInterlockedExchange(&_index.extentValid, 1);
+            }
         }
 
-        return extent;
+        return index.extent;
     }
 
     MgShape* hitTest(const Box2d& limits, Point2d& nearpt, Int32& segment) const
     {
+        const ShapeIndex& index = getIndex();
         MgShape* retshape = NULL;
         float distMin = _FLT_MAX;
 
-        for (const_iterator it = _shapes.begin(); it != _shapes.end(); ++it)
+        for (size_t i = 0; i < index.extents.size(); i++)
         {
-            const MgBaseShape* shape = (*it)->shape();
-            Box2d extent(shape->getExtent());
+            const Box2d& extent = index.extents[i];
 
             if (extent.isIntersect(limits))
             {
+                MgShape* sp = loadLazyShape(index.shapes[i]);
+                if (!sp)
+                    continue;
+                
                 Point2d tmpNear;
                 Int32   tmpSegment;
-                float  tol = (!hasFillColor(*it) ? limits.width() / 2
+                float  tol = (!hasFillColor(sp) ? limits.width() / 2
                               : mgMax(extent.width(), extent.height()));
-                float  dist = shape->hitTest(limits.center(), tol, tmpNear, tmpSegment);
+                float  dist = sp->shapec()->hitTest(limits.center(), tol, tmpNear, tmpSegment);
 
                 if (distMin > dist) {
                     distMin = dist;
                     segment = tmpSegment;
                     nearpt = tmpNear;
-                    retshape = *it;
+                    retshape = sp;
                 }
             }
         }
@@ -208,36 +420,71 @@ public:
 
     int draw(GiGraphics& gs, const GiContext *ctx = NULL) const
     {
-        Box2d clip(gs.getClipModel());
+        if (_drawByType && !ctx)
+            return drawByType(gs);
+        
+        GiStatsScope scope (gs.getStats(), GiDrawStats::kShapes);
+        const ShapeIndex& index = getIndex();
+        std::vector<UInt32> mask;
+        const long culled = cullByExtent(index, gs, mask);
         int count = 0;
         
-        for (const_iterator it = _shapes.begin(); it != _shapes.end(); ++it)
+        for (size_t i = 0; i < index.extents.size(); i++)
         {
-            if ((*it)->shape()->getExtent().isIntersect(clip)) {
-                if ((*it)->draw(gs, ctx))
+            if ((mask[i / 32] >> (i % 32)) & 1) {
+                const MgShape* sp = loadLazyShape(index.shapes[i]);
+                if (sp && sp->draw(gs, ctx))
                     count++;
             }
         }
+        if (gs.getStats())
+            gs.getStats()->addShapes((long)index.extents.size(), culled, count);
         
         return count;
     }
     
+    //! 设置是否按图形类型分组显示
+    /*! 分组显示时，显示区域内的直线段、折线和矩形按类型分组，不经过虚函数显示，
+        同一样式的相邻直线段或开口折线合并为一次批量显示。其他图形仍逐个显示。\n
+        只合并文档顺序中相邻的图形，显示先后次序与逐个显示时相同，适合图形很多时快速显示，
+        例如平移放缩时。显示时指定了绘图参数则仍逐个显示。
+    */
+    void setDrawByType(bool byType) { _drawByType = byType; }
+    
     UInt32 getChangeCount()
     {
-        return (UInt32)_changeCount;
+        return (UInt32)giAtomicLoad(&_changeCount);
     }
     
     void afterChanged()
     {
         giInterlockedIncrement(&_changeCount);
+        _index.valid = false;
+    }
+    
+    void afterShapeChanged(MgShape* shape)
+    {
+        if (!shape) {
+            giInterlockedIncrement(&_changeCount);
+        }
+        else if (_index.valid) {
+            int i = _index.find(shape);
+            if (i >= 0)
+                _index.update(i, shape->shapec()->getExtent());
+        }
     }
     
     bool save(MgStorage* s, UInt32 startIndex = 0) const
     {
         bool ret = false;
         Box2d rect;
-        UInt32 index = 0;
+        UInt32 index = 0, count = 0;
         
+        loadLazyShapes();
+        for (const_iterator it = _shapes.begin(); it != _shapes.end(); ++it, ++index) {
+            if (index >= startIndex && loadLazyShape(*it))
+                count++;                        // 跳过载入失败的图形
+        }
         if (_context) {
             if (!s->writeNode("shapedoc", -1, false))
                 return false;
@@ -245,6 +492,12 @@ public:
             s->writeFloatArray("transform", &_xf.m11, 6);
             s->writeFloat("scale", _scale);
             s->writeFloatArray("center", &_centerW.x, 2);
+            if (_originX != 0 || _originY != 0) {
+                float origin[4];        // 双精度拆为高位和低位两个单精度数
+                splitDouble(_originX, origin[0], origin[2]);
+                splitDouble(_originY, origin[1], origin[3]);
+                s->writeFloatArray("origin", origin, 4);
+            }
             rect = getExtent();
             s->writeFloatArray("extent", &rect.xmin, 4);
             s->writeUInt32("count", 1);
@@ -255,21 +508,16 @@ public:
             rect = getExtent();
             s->writeFloatArray("extent", &rect.xmin, 4);
             
-            s->writeUInt32("count", _shapes.size() - (UInt32)startIndex);
+            s->writeUInt32("count", count);
+            index = count = 0;
             for (const_iterator it = _shapes.begin(); ret && it != _shapes.end(); ++it, ++index)
             {
-                if (index < startIndex)
+                if (index < startIndex || !loadLazyShape(*it))
                     continue;
-                ret = s->writeNode("shape", index - startIndex, false);
+                ret = s->writeNode("shape", count, false);
                 if (ret) {
-                    s->writeUInt32("type", (*it)->getType() % 10000);
-                    s->writeUInt32("id", (*it)->getID());
-                    
-                    rect = (*it)->shape()->getExtent();
-                    s->writeFloatArray("extent", &rect.xmin, 4);
-                    
-                    ret = (*it)->save(s);
-                    s->writeNode("shape", index - startIndex, true);
+                    ret = saveShape(s, *it);
+                    s->writeNode("shape", count++, true);
                 }
             }
             s->writeNode("shapes", _context ? 0 : -1, true);
@@ -283,10 +531,216 @@ public:
     }
     
     bool load(MgStorage* s, bool addOnly = false)
+    {
+        return loadShapes(s, addOnly, false);
+    }
+    
+    bool loadLazily(MgStorage* s)
+    {
+        return loadShapes(s, false, true);
+    }
+    
+    void beginJournal()
+    {
+        _savedStates.clear();
+        for (const_iterator it = _shapes.begin(); it != _shapes.end(); ++it) {
+            if (!isLazyShape(*it))
+                markSaved(*it);
+        }
+        markDocSaved();
+        _journaling = true;
+    }
+    
+    int saveJournal(MgStorage* s)
+    {
+        const UInt32 gen = (UInt32)_journalCount + 1;   // 本次遇到的图形状态记下此值
+        const size_t oldCount = _savedStates.size();
+        size_t found = 0;
+        int count = 0;
+        
+        if (!s->writeNode("journal", _journalCount, false))
+            return -1;
+        saveDocState(s);
+        
+        for (const_iterator it = _shapes.begin(); it != _shapes.end(); ++it)
+        {
+            if (isLazyShape(*it))
+                continue;                                   // 未载入的图形没有改变
+            
+            UInt32 id = (*it)->getID();
+            typename SavedMap::iterator old = _savedStates.find(id);
+            const bool added = (old == _savedStates.end());
+            SavedState state;
+            
+            if (shapeChanged(*it, added ? NULL : &old->second, state)) {
+                s->writeNode("record", count, false);
+                s->writeUInt8("op", (UInt8)(added ? kJournalAdd : kJournalModify));
+                saveShape(s, *it);
+                s->writeNode("record", count++, true);
+            }
+            state.gen = gen;
+            if (added) {
+                _savedStates[id] = state;
+            }
+            else {
+                old->second = state;
+                found++;
+            }
+        }
+        for (typename SavedMap::iterator it = _savedStates.begin();
+             found < oldCount && it != _savedStates.end(); )
+        {
+            if (it->second.gen != gen) {                    // 已删除的图形
+                s->writeNode("record", count, false);
+                s->writeUInt8("op", kJournalDelete);
+                s->writeUInt32("id", it->first);
+                s->writeNode("record", count++, true);
+                _savedStates.erase(it++);
+            }
+            else {
+                ++it;
+            }
+        }
+        s->writeUInt32("count", count);
+        s->writeNode("journal", _journalCount++, true);
+        
+        markDocSaved();
+        _journaling = true;
+        
+        return count;
+    }
+    
+    bool loadJournal(MgStorage* s)
+    {
+        bool ret = true;
+        
+        if (!_journaling)
+            beginJournal();
+        for (; ret && s->readNode("journal", _journalCount, false); _journalCount++) {
+            std::vector<UInt32> order;
+            bool ordered = loadDocState(s, order);
+            
+            for (int i = 0; ret && s->readNode("record", i, false); i++) {
+                int op = s->readUInt8("op", 0);
+                UInt32 id = s->readUInt32("id", 0);
+                MgShape* shape = NULL;
+                
+                if (op == kJournalDelete) {
+                    shape = removeShape(id);
+                    if (shape)
+                        shape->release();
+                    _savedStates.erase(id);
+                }
+                else {
+                    shape = mgCreateShape(s->readUInt32("type", 0));
+                    ret = shape && loadShape(s, shape, id);
+                }
+                s->readNode("record", i, true);
+            }
+            if (ret && ordered)
+                applyOrder(order);
+            s->readNode("journal", _journalCount, true);
+        }
+        markDocSaved();
+        
+        return ret;
+    }
+    
+    bool compactJournal(MgStorage* s)
+    {
+        bool ret = save(s);
+        
+        if (ret) {
+            beginJournal();
+            _journalCount = 0;
+        }
+        
+        return ret;
+    }
+
+    //! 载入所有延迟载入的图形内容，返回本次载入成功的图形个数
+    UInt32 loadLazyShapes() const
+    {
+        UInt32 n = 0;
+        for (const_iterator it = _shapes.begin(); giAtomicLoad(&_lazyCount) && it != _shapes.end(); ++it)
+        {
+            loadLazyShape(*it, &n);
+        }
+        return n;
+    }
+
+    GiContext* context()
+    {
+        return _context;
+    }
+    
+    Matrix2d& modelTransform()
+    {
+        return _xf;
+    }
+    
+    float getViewScale() const
+    {
+        return _scale;
+    }
+    
+    Point2d getViewCenterW() const
+    {
+        return _centerW;
+    }
+    
+    void setZoomState(float scale, const Point2d& centerW)
+    {
+        _scale = scale;
+        _centerW = centerW;
+    }
+    
+    double getOriginX() const
+    {
+        return _originX;
+    }
+    
+    double getOriginY() const
+    {
+        return _originY;
+    }
+    
+    void setOrigin(double x, double y)
+    {
+        Vector2d offset ((float)(_originX - x), (float)(_originY - y));
+        
+        _originX -= offset.x;                       // 与图形实际的单精度平移量一致
+        _originY -= offset.y;
+        _centerW += offset;
+        if (offset.x != 0 || offset.y != 0) {
+            Matrix2d mat (Matrix2d::translation(offset));
+            
+            loadLazyShapes();
+            for (iterator it = _shapes.begin(); it != _shapes.end(); ++it) {
+                (*it)->shape()->transform(mat);
+                (*it)->shape()->update();
+            }
+            afterChanged();
+        }
+    }
+    
+    void applyOrigin(GiTransform& xf) const
+    {
+        xf.setWorldOrigin(_originX, _originY);
+    }
+    
+    virtual MgLockRW* getLockData()
+    {
+        return &_lock;
+    }
+
+private:
+    bool loadShapes(MgStorage* s, bool addOnly, bool lazy)
     {
         bool ret = false;
         Box2d rect;
         int index = 0;
+        float origin[4] = { 0, 0, 0, 0 };           // 没有原点字段的文档原点为0
         
         if (_context) {
             if (!s->readNode("shapedoc", -1, false))
@@ -295,6 +749,7 @@ public:
             s->readFloatArray("transform", &_xf.m11, 6);
             _scale = s->readFloat("scale", _scale);
             s->readFloatArray("center", &_centerW.x, 2);
+            s->readFloatArray("origin", origin, 4);
             s->readFloatArray("extent", &rect.xmin, 4);
             s->readUInt32("count", 0);
         }
@@ -304,22 +759,36 @@ public:
             s->readFloatArray("extent", &rect.xmin, 4);
             s->readUInt32("count", 0);
             
-            if (!addOnly)
+            if (!addOnly) {
                 clear();
+                _originX = (double)origin[0] + origin[2];
+                _originY = (double)origin[1] + origin[3];
+            }
+            else {
+                loadLazyShapes();
+            }
             
             while (ret && s->readNode("shape", index, false)) {
                 UInt32 type = s->readUInt32("type", 0);
                 UInt32 id = s->readUInt32("id", 0);
                 MgShape* shape = mgCreateShape(type);
+                bool extentRead = (s->readFloatArray("extent", &rect.xmin, 4) == 4);
                 
-                s->readFloatArray("extent", &rect.xmin, 4);
                 if (shape) {
                     shape->setParent(this, id);
-                    ret = shape->load(s);
-                    if (ret) {
+                    if (lazy && extentRead) {               // 只记下范围，以后再载入
+                        LazyItem item = { index, rect, false };
+                        _lazyShapes[shape] = item;
+                        _lazyStorage = s;
+                        _shapes.push_back(shape);
+                    }
+                    else if (shape->load(s)) {
                         _shapes.push_back(shape);
+                        if (_journaling)
+                            markSaved(shape);
                     }
                     else {
+                        ret = false;
                         shape->release();
                     }
                 }
@@ -331,54 +800,536 @@ public:
         if (_context) {
             s->readNode("shapedoc", -1, true);
         }
+        _lazyCount = (long)_lazyShapes.size();
+        afterChanged();
+        if (_journaling && !addOnly)
+            markDocSaved();
         
         return ret;
     }
-
-    GiContext* context()
+    
+    //! 载入延迟载入的图形内容，载入失败时返回NULL
+    /*! 可在读锁定期间的多个线程中调用，各次载入依次进行。载入后更新该图形的索引项，
+        载入失败的图形仍留在列表中，以空范围不显示，以后不再载入。
+    */
+    MgShape* loadLazyShape(MgShape* shape, UInt32* loaded = NULL) const
     {
-        return _context;
+        if (!shape || !giAtomicLoad(&_lazyCount))
+            return shape;
+        
+        GiMutexLock locker(_lazyMutex);
+        typename LazyMap::iterator it = _lazyShapes.find(shape);
+        
+        if (it == _lazyShapes.end())
+            return shape;
+        if (it->second.failed)
+            return NULL;
+        
+        const int i = findIndexItem(shape, it->second.index);
+        
+        if (!readLazyShape(shape, it->second.index)) {
+            it->second.failed = true;
+            it->second.extent.empty();
+            if (i >= 0)
+                _index.update(i, Box2d());
+            return NULL;
+        }
+        
+        _lazyShapes.erase(it);
+        if (_lazyShapes.empty())
+            _lazyStorage = NULL;
+        giInterlockedDecrement(&_lazyCount);
+        
+        if (i >= 0) {                               // 索引中原为记下的范围
+            Box2d extent (shape->shapec()->getExtent());
+            if (extent != _index.extents[i])
+                _index.update(i, extent);
+        }
+        if (loaded)
+            (*loaded)++;
+        
+        return shape;
     }
     
-    Matrix2d& modelTransform()
+    //! 从延迟载入时的当前节点重新进入该图形的节点读取
+    bool readLazyShape(MgShape* shape, int index) const
     {
-        return _xf;
+        MgStorage* s = _lazyStorage;
+        bool ret = false;
+        
+        if (!_context || s->readNode("shapedoc", -1, false)) {
+            if (s->readNode("shapes", _context ? 0 : -1, false)) {
+                if (s->readNode("shape", index, false)) {
+                    ret = shape->load(s);
+                    if (ret && _journaling)
+                        markSaved(shape);
+                    s->readNode("shape", index, true);
+                }
+                s->readNode("shapes", _context ? 0 : -1, true);
+            }
+            if (_context)
+                s->readNode("shapedoc", -1, true);
+        }
+        return ret;
     }
     
-    float getViewScale() const
+    //! 返回图形在已生成的索引中的序号，hint 为可能的序号，没有索引时返回-1
+    int findIndexItem(const MgShape* shape, int hint) const
     {
-        return _scale;
+        if (!_index.valid)
+            return -1;
+        if (hint >= 0 && hint < (int)_index.shapes.size() && _index.shapes[hint] == shape)
+            return hint;
+        return _index.find(shape);
     }
     
-    Point2d getViewCenterW() const
+    //! 返回图形是否尚未载入或载入失败
+    bool isLazyShape(const MgShape* shape) const
     {
-        return _centerW;
+        if (!giAtomicLoad(&_lazyCount))
+            return false;
+        GiMutexLock locker(_lazyMutex);
+        return _lazyShapes.find(shape) != _lazyShapes.end();
     }
     
-    void setZoomState(float scale, const Point2d& centerW)
+    //! 从延迟载入表中去掉图形，其对象地址以后可能被新图形重用
+    void forgetLazyShape(const MgShape* shape)
     {
-        _scale = scale;
-        _centerW = centerW;
+        GiMutexLock locker(_lazyMutex);
+        if (_lazyShapes.erase(shape) > 0) {
+            _lazyCount = (long)_lazyShapes.size();
+            if (_lazyShapes.empty())
+                _lazyStorage = NULL;
+        }
     }
     
-    virtual MgLockRW* getLockData()
+    //! 从迭代位置开始返回第一个能载入的图形，跳过载入失败的图形
+    MgShape* loadFrom(const_iterator& it) const
     {
-        return &_lock;
+        for (; it != _shapes.end(); ++it) {
+            MgShape* shape = loadLazyShape(*it);
+            if (shape)
+                return shape;
+        }
+        return NULL;
     }
-
-private:
+    
+    bool saveShape(MgStorage* s, const MgShape* shape) const
+    {
+        Box2d rect(shape->shapec()->getExtent());
+        
+        s->writeUInt32("type", shape->getType() % 10000);
+        s->writeUInt32("id", shape->getID());
+        s->writeFloatArray("extent", &rect.xmin, 4);
+        
+        return shape->save(s);
+    }
+    
+    //! 载入追加记录中的新图形，替换同ID的图形或添加到末尾
+    bool loadShape(MgStorage* s, MgShape* shape, UInt32 id)
+    {
+        shape->setParent(this, id);
+        if (!shape->load(s)) {
+            shape->release();
+            return false;
+        }
+        
+        iterator it = _shapes.begin();
+        for (; it != _shapes.end() && (*it)->getID() != id; ++it) ;
+        
+        if (it != _shapes.end()) {
+            _lazyShapes.erase(*it);
+            _lazyCount = (long)_lazyShapes.size();
+            (*it)->release();
+            *it = shape;
+        }
+        else {
+            _shapes.push_back(shape);
+        }
+        if (_journaling)
+            markSaved(shape);
+        _index.valid = false;
+        
+        return true;
+    }
+    
+    //! 图形在上次追加保存或开始记录时的状态
+    struct SavedState {
+        const MgShape*  shape;              //!< 图形对象，被替换后不同
+        UInt32          changes;            //!< update() 和改变标志位的次数
+        UInt32          attrs;              //!< 标签和绘图属性的散列值，用于检查只改了属性的图形
+        UInt32          hash;               //!< 保存内容的散列值
+        UInt32          gen;                //!< 最近一次追加保存时遇到该图形的序号
+    };
+    typedef std::map<UInt32, SavedState> SavedMap;
+    
+    static UInt32 attrsHash(const MgShape* shape)
+    {
+        MgHashStorage s;
+        const GiContext* ctx = shape->contextc();
+        
+        s.writeUInt32("tag", shape->getTag());
+        s.writeUInt8("lineStyle", (UInt8)ctx->getLineStyle());
+        s.writeFloat("lineWidth", ctx->getLineWidth());
+        s.writeUInt32("lineColor", (UInt32)ctx->getLineColor().getARGB());
+        s.writeUInt32("fillColor", (UInt32)ctx->getFillColor().getARGB());
+        s.writeBool("autoFillColor", ctx->isAutoFillColor());
+        
+        return s.hash;
+    }
+    
+    static SavedState savedState(const MgShape* shape)
+    {
+        MgHashStorage s;
+        s.writeUInt32("type", shape->getType());
+        shape->save(&s);
+        
+        SavedState state = { shape, shape->shapec()->getChangeCount(), attrsHash(shape), s.hash, 0 };
+        return state;
+    }
+    
+    //! 返回图形相对上次保存的状态 old 是否改变，state 为新状态
+    /*! 图形对象、改变次数和属性散列值都相同时不再序列化图形，否则比较保存内容的散列值。 */
+    static bool shapeChanged(const MgShape* shape, const SavedState* old, SavedState& state)
+    {
+        if (old && old->shape == shape && old->changes == shape->shapec()->getChangeCount()
+            && old->attrs == attrsHash(shape)) {
+            state = *old;
+            return false;
+        }
+        state = savedState(shape);
+        return !old || old->shape != shape || old->hash != state.hash;
+    }
+    
+    void markSaved(const MgShape* shape) const
+    {
+        _savedStates[shape->getID()] = savedState(shape);
+    }
+    
+    //! 记下文档变换、显示比例、中心点、原点和图形顺序，作为下次追加保存的比较基准
+    void markDocSaved()
+    {
+        _savedDoc.xf = _xf;
+        _savedDoc.scale = _scale;
+        _savedDoc.centerW = _centerW;
+        _savedDoc.originX = _originX;
+        _savedDoc.originY = _originY;
+        _savedOrder.clear();
+        _savedOrder.reserve(_shapes.size());
+        for (const_iterator it = _shapes.begin(); it != _shapes.end(); ++it)
+            _savedOrder.push_back((*it)->getID());
+    }
+    
+    //! 返回按记录重放后的图形顺序是否与当前顺序相同，ids 为当前顺序
+    /*! 重放时修改的图形原位替换，删除的图形去掉，新图形按记录顺序添加到末尾。 */
+    bool sameOrder(const std::vector<UInt32>& ids) const
+    {
+        if (ids.size() >= _savedOrder.size()                // 常见情况：只在末尾添加了图形
+            && std::equal(_savedOrder.begin(), _savedOrder.end(), ids.begin())) {
+            return true;
+        }
+        
+        std::vector<UInt32> current(ids), saved(_savedOrder), replayed;
+        std::sort(current.begin(), current.end());
+        std::sort(saved.begin(), saved.end());
+        replayed.reserve(ids.size());
+        for (size_t i = 0; i < _savedOrder.size(); i++) {
+            if (std::binary_search(current.begin(), current.end(), _savedOrder[i]))
+                replayed.push_back(_savedOrder[i]);
+        }
+        for (size_t i = 0; i < ids.size(); i++) {
+            if (!std::binary_search(saved.begin(), saved.end(), ids[i]))
+                replayed.push_back(ids[i]);
+        }
+        return replayed == ids;
+    }
+    
+    //! 在追加记录节点中写出改变了的文档状态
+    /*! "doc" 节点有文档变换等状态，图形顺序与重放结果不同时还有 "order" 数组，
+        每个ID拆为高16位和低16位两个浮点数。
+    */
+    void saveDocState(MgStorage* s) const
+    {
+        std::vector<UInt32> ids;
+        ids.reserve(_shapes.size());
+        for (const_iterator it = _shapes.begin(); it != _shapes.end(); ++it)
+            ids.push_back((*it)->getID());
+        
+        const bool ordered = !_journaling || sameOrder(ids);
+        if (_journaling && ordered && _scale == _savedDoc.scale
+            && _centerW.x == _savedDoc.centerW.x && _centerW.y == _savedDoc.centerW.y
+            && _originX == _savedDoc.originX && _originY == _savedDoc.originY
+            && std::equal(&_xf.m11, &_xf.m11 + 6, &_savedDoc.xf.m11)) {
+            return;
+        }
+        
+        s->writeNode("doc", -1, false);
+        s->writeFloatArray("transform", &_xf.m11, 6);
+        s->writeFloat("scale", _scale);
+        s->writeFloatArray("center", &_centerW.x, 2);
+        
+        float origin[4];
+        splitDouble(_originX, origin[0], origin[2]);
+        splitDouble(_originY, origin[1], origin[3]);
+        s->writeFloatArray("origin", origin, 4);
+        if (!ordered) {
+            std::vector<float> order(ids.size() * 2);
+            for (size_t i = 0; i < ids.size(); i++) {
+                order[2 * i] = (float)(ids[i] >> 16);
+                order[2 * i + 1] = (float)(ids[i] & 0xFFFF);
+            }
+            s->writeFloatArray("order", &order.front(), (int)order.size());
+        }
+        s->writeNode("doc", -1, true);
+    }
+    
+    //! 读取追加记录节点中的文档状态，返回是否有图形顺序
+    bool loadDocState(MgStorage* s, std::vector<UInt32>& ids)
+    {
+        if (!s->readNode("doc", -1, false))
+            return false;
+        
+        s->readFloatArray("transform", &_xf.m11, 6);
+        _scale = s->readFloat("scale", _scale);
+        s->readFloatArray("center", &_centerW.x, 2);
+        
+        float origin[4];
+        if (s->readFloatArray("origin", origin, 4) == 4) {
+            _originX = (double)origin[0] + origin[2];
+            _originY = (double)origin[1] + origin[3];
+        }
+        
+        std::vector<float> order(s->readFloatArray("order", NULL, 0));
+        if (!order.empty())
+            s->readFloatArray("order", &order.front(), (int)order.size());
+        ids.resize(order.size() / 2);
+        for (size_t i = 0; i < ids.size(); i++)
+            ids[i] = ((UInt32)order[2 * i] << 16) | (UInt32)order[2 * i + 1];
+        
+        s->readNode("doc", -1, true);
+        return !order.empty();
+    }
+    
+    //! 按ID顺序重排图形，未列出的图形按原顺序放在后面
+    void applyOrder(const std::vector<UInt32>& ids)
+    {
+        std::vector<std::pair<UInt32, MgShape*> > byID;
+        byID.reserve(_shapes.size());
+        for (const_iterator it = _shapes.begin(); it != _shapes.end(); ++it)
+            byID.push_back(std::make_pair((*it)->getID(), *it));
+        std::sort(byID.begin(), byID.end());
+        
+        Container shapes;
+        for (size_t i = 0; i < ids.size(); i++) {
+            typename std::vector<std::pair<UInt32, MgShape*> >::iterator it =
+                std::lower_bound(byID.begin(), byID.end(), std::make_pair(ids[i], (MgShape*)NULL));
+            if (it != byID.end() && it->first == ids[i] && it->second) {
+                shapes.push_back(it->second);
+                it->second = NULL;
+            }
+        }
+        for (const_iterator it = _shapes.begin(); it != _shapes.end(); ++it) {
+            typename std::vector<std::pair<UInt32, MgShape*> >::iterator p =
+                std::lower_bound(byID.begin(), byID.end(), std::make_pair((*it)->getID(), (MgShape*)NULL));
+            if (p != byID.end() && p->second == *it)
+                shapes.push_back(*it);
+        }
+        _shapes.swap(shapes);
+        afterChanged();
+    }
+    
+    //! 返回是否为载入失败的图形，载入失败的图形在索引中为空范围
+    bool isLazyFailed(const MgShape* shape) const
+    {
+        if (!giAtomicLoad(&_lazyCount))
+            return false;
+        
+        GiMutexLock locker(_lazyMutex);
+        typename LazyMap::const_iterator it = _lazyShapes.find(shape);
+        return it != _lazyShapes.end() && it->second.failed;
+    }
+    
+    //! 返回图形范围，未载入的图形返回文档中记下的范围
+    Box2d getShapeExtent(const MgShape* shape) const
+    {
+        if (!_lazyShapes.empty()) {
+            typename LazyMap::const_iterator it = _lazyShapes.find(shape);
+            if (it != _lazyShapes.end())
+                return it->second.extent;
+        }
+        return shape->shapec()->getExtent();
+    }
+    
+    MgShape* findShapeNoLoad(UInt32 nID) const
+    {
+        const ShapeIndex& index = getIndex();
+        int i = index.findID(nID);
+        
+        return i < 0 ? NULL : index.shapes[i];
+    }
+    
+    //! 返回图形的并行数组索引，图形增删或改变后重新生成
+    /*! 可在读锁定期间的多个线程中调用，只有一个线程重新生成，其余线程等待生成后再使用。
+        持有 _lazyMutex 时不能调用。
+    */
+    const ShapeIndex& getIndex() const
+    {
+        if (giAtomicLoad(&_index.valid))
+            return _index;
+        
+        GiMutexLock locker(_lazyMutex);
+        
+        if (!_index.valid) {
+            _index.clear();
+            for (const_iterator it = _shapes.begin(); it != _shapes.end(); ++it)
+                _index.add(*it, getShapeExtent(*it));
+            giInterlockedExchange(&_index.valid, 1);
+        }
+        return _index;
+    }
+    
+    //! 批量判断各图形是否在显示区域内，结果按位存放，返回在显示区域外的图形个数
+    static long cullByExtent(const ShapeIndex& index, const GiGraphics& gs, std::vector<UInt32>& mask)
+    {
+        const int n = (int)index.extents.size();
+        
+        mask.resize(n / 32 + 1);
+        return n - (n > 0 ? gs.getClipModel().intersectMask(n, &index.extents.front(), &mask.front()) : 0);
+    }
+    
+    // 只用于取核心图形的类型号，图形对象不一定是这些类
+    typedef MgShapeT<MgLine, ContextT>  LineShape;
+    typedef MgShapeT<MgLines, ContextT> LinesShape;
+    typedef MgShapeT<MgRect, ContextT>  RectShape;
+    
+    //! 按图形类型快速显示，文档顺序中相邻的同样式直线段或开口折线合并为一次批量显示
+    /*! 只合并相邻的图形，显示次序与逐个显示时相同。
+        核心图形类型号不能被 mgRegisterShapeCreator 替换，按类型号将 shapec() 转换为核心图形类，
+        不转换图形对象本身，图形对象可以是任意绘图属性类型的 MgShapeT。
+    */
+    int drawByType(GiGraphics& gs) const
+    {
+        GiStatsScope scope (gs.getStats(), GiDrawStats::kShapes);
+        const ShapeIndex& index = getIndex();
+        std::vector<UInt32> mask;
+        const long culled = cullByExtent(index, gs, mask);
+        std::vector<size_t> run;                    // 待合并显示的相邻图形
+        UInt32 runType = 0;
+        int count = 0;
+        
+        for (size_t i = 0; i < index.extents.size(); i++)
+        {
+            if (!((mask[i / 32] >> (i % 32)) & 1))
+                continue;                           // 不显示的图形不影响其余图形的次序
+            const MgShape* sp = loadLazyShape(index.shapes[i]);
+            if (!sp)
+                continue;
+            
+            const UInt32 type = index.types[i];
+            const bool batch = (type == LineShape::Type() || (type == LinesShape::Type()
+                && !sp->shapec()->getFlag(kMgClosed)));
+            
+            if (!run.empty() && !(batch && type == runType
+                                  && sp->contextc()->equals(*index.shapes[run.front()]->contextc()))) {
+                count += drawRun(gs, index, runType, run);
+            }
+            if (batch) {
+                runType = type;
+                run.push_back(i);
+            }
+            else if (type == RectShape::Type()) {
+                const MgBaseRect* rect = (const MgBaseRect*)sp->shapec();
+                if (gs.drawPolygon(sp->contextc(), 4, rect->getCorners()))
+                    count++;
+            }
+            else if (type == LinesShape::Type()) {  // 闭合折线
+                const MgBaseLines* lines = (const MgBaseLines*)sp->shapec();
+                if (lines->isPacked() ? lines->draw(gs, *sp->contextc()) // 不恢复为浮点存储
+                    : gs.drawPolygon(sp->contextc(), lines->getCount(), lines->getPoints()))
+                    count++;
+            }
+            else if (sp->draw(gs)) {
+                count++;
+            }
+        }
+        count += drawRun(gs, index, runType, run);
+        
+        if (gs.getStats())
+            gs.getStats()->addShapes((long)index.extents.size(), culled, count);
+        
+        return count;
+    }
+    
+    //! 显示并清空待合并显示的相邻图形，返回显示了的图形个数
+    static int drawRun(GiGraphics& gs, const ShapeIndex& index, UInt32 type, std::vector<size_t>& run)
+    {
+        int count = 0;
+        
+        if (!run.empty()) {
+            count = (type == LineShape::Type() ? drawRun<MgLine>(gs, index, run)
+                     : drawRun<MgBaseLines>(gs, index, run));
+            run.clear();
+        }
+        return count;
+    }
+    
+    static int addPoints(std::vector<Point2d>& points, const MgLine& shape)
+    {
+        points.push_back(shape.startPoint());
+        points.push_back(shape.endPoint());
+        return 2;
+    }
+    
+    static int addPoints(std::vector<Point2d>& points, const MgBaseLines& shape)
+    {
+        const size_t n = points.size();
+        
+        if (shape.getCount() > 0) {         // 压缩存储时直接解码
+            points.resize(n + shape.getCount());
+            shape.copyPoints(0, shape.getCount(), &points[n]);
+        }
+        return (int)shape.getCount();
+    }
+    
+    //! 将同一样式的相邻直线段或开口折线合并为一次批量显示，ShapeT 为 MgLine 或 MgBaseLines
+    template <class ShapeT>
+    static int drawRun(GiGraphics& gs, const ShapeIndex& index, const std::vector<size_t>& run)
+    {
+        const MgShape* first = index.shapes[run.front()];
+        
+        if (run.size() == 1) {                      // 单个图形与逐个显示时相同
+            return first->shapec()->draw(gs, *first->contextc()) ? 1 : 0;
+        }
+        
+        std::vector<Point2d> points;
+        std::vector<int> counts;
+        
+        for (size_t j = 0; j < run.size(); j++) {
+            const ShapeT* shape = (const ShapeT*)index.shapes[run[j]]->shapec();
+            counts.push_back(addPoints(points, *shape));
+        }
+        if (gs.drawLinesBatch(first->contextc(), (int)counts.size(), &counts.front(), &points.front()))
+            return (int)counts.size();
+        return 0;
+    }
+    
     UInt32 getNewID(UInt32 nID)
     {
-        if (0 == nID || findShape(nID)) {
-            nID = 1;
-            if (!_shapes.empty())
-                nID = _shapes.back()->getID() + 1;
-            while (findShape(nID))
-                nID++;
+        const ShapeIndex& index = getIndex();
+        
+        // 大于最大ID的不会重复，新图形取最大ID加1，不必逐个查找
+        if (0 == nID || (nID <= index.maxID && findShapeNoLoad(nID))) {
+            nID = index.maxID + 1;
         }
         return nID;
     }
     
+    static void splitDouble(double value, float& high, float& low)
+    {
+        high = (float)value;
+        low = (float)(value - high);
+    }
+    
     bool hasFillColor(const MgShape* shape) const
     {
         return shape->contextc()->hasFillColor() && shape->shapec()->isClosed();
@@ -390,8 +1341,39 @@ protected:
     Matrix2d                _xf;
     float                   _scale;
     Point2d                 _centerW;
+    double                  _originX;       //!< 文档原点的绝对坐标X
+    double                  _originY;       //!< 文档原点的绝对坐标Y
     long                    _changeCount;
     MgLockRW                _lock;
+    
+private:
+    struct LazyItem {                       //!< 延迟载入的图形在文档中的序号和范围
+        int     index;
+        Box2d   extent;
+        bool    failed;                     //!< 是否已载入失败
+    };
+    typedef std::map<const MgShape*, LazyItem> LazyMap;
+    mutable LazyMap         _lazyShapes;    //!< 尚未载入内容或载入失败的图形
+    mutable MgStorage*      _lazyStorage;   //!< 延迟载入用的存取对象
+    mutable volatile long   _lazyCount;     //!< _lazyShapes 的图形个数，为0时不必加锁查找
+    mutable GiMutex         _lazyMutex;     //!< 延迟载入和重新生成索引时互斥
+    
+    mutable ShapeIndex      _index;         //!< 图形索引，afterChanged() 后重新生成
+    
+    enum { kJournalAdd = 1, kJournalModify, kJournalDelete };
+    mutable SavedMap        _savedStates;   //!< 已保存的各图形的状态，开始记录后才有
+    struct DocState {
+        Matrix2d            xf;
+        float               scale;
+        Point2d             centerW;
+        double              originX;
+        double              originY;
+    };
+    DocState                _savedDoc;      //!< 已保存的文档状态，开始记录后才有
+    std::vector<UInt32>     _savedOrder;    //!< 已保存的图形ID顺序，开始记录后才有
+    int                     _journalCount;  //!< 已追加保存的记录节点数
+    bool                    _journaling;    //!< 是否已开始记录增删改
+    bool                    _drawByType;    //!< 是否按图形类型分组显示
 };
 
 #endif // __GEOMETRY_MGSHAPES_TEMPL_H_
@@ -9,6 +9,88 @@
 #include <gigraph.h>
 #include <mgshape.h>
 #include <mgstorage.h>
+#include <gisync.h>
+#include <new>
+
+//! 对象内存池模板类
+/*! 按块成批分配同类对象的内存，释放的内存放入空闲链表以便重用。
+    每个类型一个内存池，由进程内所有图形文档共用，不属于某个文档，清除文档时仍逐个析构图形。
+    图形通常在文档写锁定期间增删，各线程很少同时分配，加锁只是一次原子操作。
+    该类型的对象全部释放后（例如关闭所有文档时）将其余各块内存归还系统，只保留一块，
+    反复创建和释放单个图形时不必每次向系统申请内存。
+    \ingroup GEOM_SHAPE
+    \param T 对象类型
+    \param BlockSize 每块的对象个数
+*/
+template <class T, int BlockSize = 64>
+class MgObjectPool
+{
+    union Node {
+        Node*   next;
+        double  align;
+        char    data[sizeof(T)];
+    };
+public:
+    //! 分配一个对象的内存
+    static void* allocate()
+    {
+        _mutex.lock();
+        if (!_freeList) {
+            Node* block = (Node*)::operator new(sizeof(Node) * (BlockSize + 1));
+            block[0].next = _blocks;            // 首个节点用于链接各块
+            _blocks = block;
+            for (int i = 1; i <= BlockSize; i++) {
+                block[i].next = _freeList;
+                _freeList = block + i;
+            }
+        }
+        Node* node = _freeList;
+        _freeList = node->next;
+        _used++;
+        _mutex.unlock();
+        return node;
+    }
+    
+    //! 归还一个对象的内存
+    static void deallocate(void* p)
+    {
+        if (p) {
+            _mutex.lock();
+            ((Node*)p)->next = _freeList;
+            _freeList = (Node*)p;
+            if (--_used == 0 && _blocks[0].next) {
+                Node* block = _blocks[0].next;
+                _blocks[0].next = NULL;
+                while (block) {
+                    Node* next = block[0].next;
+                    ::operator delete(block);
+                    block = next;
+                }
+                _freeList = NULL;               // 空闲链表只剩保留的块中的节点
+                for (int i = 1; i <= BlockSize; i++) {
+                    _blocks[i].next = _freeList;
+                    _freeList = _blocks + i;
+                }
+            }
+            _mutex.unlock();
+        }
+    }
+    
+private:
+    static Node*            _freeList;
+    static Node*            _blocks;    // 已分配的块
+    static long             _used;      // 未归还的对象个数
+    static GiMutex          _mutex;     // 全零即为未加锁，不依赖静态构造顺序
+};
+
+template <class T, int BlockSize>
+typename MgObjectPool<T, BlockSize>::Node* MgObjectPool<T, BlockSize>::_freeList = NULL;
+template <class T, int BlockSize>
+typename MgObjectPool<T, BlockSize>::Node* MgObjectPool<T, BlockSize>::_blocks = NULL;
+template <class T, int BlockSize>
+long MgObjectPool<T, BlockSize>::_used = 0;
+template <class T, int BlockSize>
+GiMutex MgObjectPool<T, BlockSize>::_mutex;
 
 //! 矢量图形模板类
 /*! \ingroup GEOM_SHAPE
@@ -32,6 +114,21 @@ public:
     {
     }
     
+    //! 从本类的内存池中分配，派生类对象仍使用全局分配
+    static void* operator new(size_t size)
+    {
+        return size == sizeof(ThisClass) ? MgObjectPool<ThisClass>::allocate()
+            : ::operator new(size);
+    }
+    
+    static void operator delete(void* p, size_t size)
+    {
+        if (size == sizeof(ThisClass))
+            MgObjectPool<ThisClass>::deallocate(p);
+        else
+            ::operator delete(p);
+    }
+    
     GiContext* context()
     {
         return &_context;
@@ -4,15 +4,22 @@
 #include <stdlib.h>
 #include <time.h>
 
+static bool s_inited = false;
+
 void RandomParam::init()
 {
-    static bool inited = false;
-    if (!inited) {
-        inited = true;
+    if (!s_inited) {
+        s_inited = true;
         srand((unsigned)time(NULL));
     }
 }
 
+void RandomParam::init(unsigned int seed)
+{
+    s_inited = true;
+    srand(seed);
+}
+
 float RandomParam::RandF(float dMin, float dMax)
 {
     return (rand() % mgRound((dMax - dMin) * 10)) * 0.1f + dMin;
@@ -12,6 +12,7 @@ struct RandomParam
     bool randomLineStyle;
     
     static void init();
+    static void init(unsigned int seed);    // 指定种子，每次生成相同的图形
 
     RandomParam() : lineCount(10), rectCount(10), arcCount(10), curveCount(10), randomLineStyle(true) {}
 
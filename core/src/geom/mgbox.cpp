@@ -5,6 +5,12 @@
 #include "mgbox.h"
 #include "mgmat.h"
 
+// 有SSE时用向量指令批量计算包络框，Point2d 和 Box2d 都是连续存放的浮点数，不要求对齐
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define MG_BOX_SSE
+#endif
+
 Box2d::Box2d(const BOX_2D& src, bool bNormalize)
 {
     xmin = src.xmin;
@@ -63,6 +69,34 @@ Box2d& Box2d::set(int count, const Point2d* points)
     if (count < 1 || !points)
         return empty();
 
+#ifdef MG_BOX_SSE
+    __m128 mn = _mm_setr_ps(points[0].x, points[0].y, points[0].x, points[0].y);
+    __m128 mx = mn;
+    int i = 0;
+
+    for (; i + 1 < count; i += 2)           // 每次取两个点
+    {
+        __m128 v = _mm_loadu_ps(&points[i].x);
+        mn = _mm_min_ps(mn, v);
+        mx = _mm_max_ps(mx, v);
+    }
+    if (i < count)
+    {
+        __m128 v = _mm_setr_ps(points[i].x, points[i].y, points[i].x, points[i].y);
+        mn = _mm_min_ps(mn, v);
+        mx = _mm_max_ps(mx, v);
+    }
+    mn = _mm_min_ps(mn, _mm_movehl_ps(mn, mn));
+    mx = _mm_max_ps(mx, _mm_movehl_ps(mx, mx));
+
+    float v[8];
+    _mm_storeu_ps(v, mn);
+    _mm_storeu_ps(v + 4, mx);
+    xmin = v[0];
+    ymin = v[1];
+    xmax = v[4];
+    ymax = v[5];
+#else
     set(points[0], points[0]);
     for (int i = 0; i < count; i++)
     {
@@ -75,12 +109,113 @@ Box2d& Box2d::set(int count, const Point2d* points)
         if (ymax < points[i].y)
             ymax = points[i].y;
     }
+#endif
     if (isEmpty())
         inflate(Tol::gTol().equalPoint());
 
     return *this;
 }
 
+Box2d& Box2d::unionWith(int count, const Box2d* boxes)
+{
+    const float tol = Tol::gTol().equalPoint();
+    int i = 0;
+
+    // 本矩形框为空时与 unionWith(box) 相同，取第一个非空矩形框，或规范化后再合并
+    for (; i < count && isEmptyMinus(); i++)
+    {
+        if (boxes[i].isEmptyMinus())
+            normalize();
+        else
+            set(boxes[i], true);
+    }
+    if (i == count)
+        return *this;
+
+#ifdef MG_BOX_SSE
+    const __m128 tolv = _mm_set1_ps(tol);
+    __m128 mn = _mm_loadu_ps(&xmin);
+    __m128 mx = mn;
+
+    for (; i < count; i++)
+    {
+        __m128 b = _mm_loadu_ps(&boxes[i].xmin);
+        __m128 d = _mm_sub_ps(_mm_movehl_ps(b, b), b);      // 宽, 高
+
+        if ((_mm_movemask_ps(_mm_cmpge_ps(d, tolv)) & 3) == 3)
+        {
+            mn = _mm_min_ps(mn, b);
+            mx = _mm_max_ps(mx, b);
+        }
+    }
+
+    float v[8];
+    _mm_storeu_ps(v, mn);
+    _mm_storeu_ps(v + 4, mx);
+    xmin = v[0];
+    ymin = v[1];
+    xmax = v[6];
+    ymax = v[7];
+#else
+    for (; i < count; i++)
+    {
+        const Box2d& b = boxes[i];
+        if (b.xmax - b.xmin < tol || b.ymax - b.ymin < tol)
+            continue;
+        xmin = mgMin(xmin, b.xmin);
+        ymin = mgMin(ymin, b.ymin);
+        xmax = mgMax(xmax, b.xmax);
+        ymax = mgMax(ymax, b.ymax);
+    }
+#endif
+
+    return *this;
+}
+
+int Box2d::intersectMask(int count, const Box2d* boxes, UInt32* mask) const
+{
+    int n = 0;
+
+    for (int i = 0; i < (count + 31) / 32; i++)
+        mask[i] = 0;
+    if (xmax - xmin < -_MGZERO || ymax - ymin < -_MGZERO || isNull())
+        return 0;
+
+#ifdef MG_BOX_SSE
+    const __m128 sign = _mm_setr_ps(1.f, 1.f, -1.f, -1.f);
+    const __m128 limit = _mm_setr_ps(xmax, ymax, -xmin, -ymin);
+    const __m128 zero = _mm_set1_ps(_MGZERO);
+    const __m128 minusZero = _mm_set1_ps(-_MGZERO);
+
+    for (int i = 0; i < count; i++)
+    {
+        __m128 b = _mm_loadu_ps(&boxes[i].xmin);
+        __m128 d = _mm_sub_ps(_mm_movehl_ps(b, b), b);      // 宽, 高
+        __m128 a = _mm_max_ps(b, _mm_sub_ps(_mm_setzero_ps(), b));  // 绝对值
+
+        // b.xmin <= xmax, b.ymin <= ymax, b.xmax >= xmin, b.ymax >= ymin
+        if (_mm_movemask_ps(_mm_cmple_ps(_mm_mul_ps(b, sign), limit)) == 15
+            && (_mm_movemask_ps(_mm_cmpge_ps(d, minusZero)) & 3) == 3
+            && _mm_movemask_ps(_mm_cmplt_ps(a, zero)) != 15)
+        {
+            mask[i / 32] |= 1UL << (i % 32);
+            n++;
+        }
+    }
+#else
+    for (int i = 0; i < count; i++)
+    {
+        if (isIntersect(boxes[i]))
+        {
+            mask[i / 32] |= 1UL << (i % 32);
+            n++;
+        }
+    }
+#endif
+
+    return n;
+}
+
 bool Box2d::isIntersect(const Box2d& box) const
 {
     if (xmax - xmin < -_MGZERO || ymax - ymin < -_MGZERO || isNull())
@@ -18,6 +18,47 @@ GEOMAPI void mgFitBezier(const Point2d* pts, float t, Point2d& fitpt)
         + 3 * t2 * v * pts[2].y + t2 * t * pts[3].y;
 }
 
+GEOMAPI Int32 mgBezierSegments(const Point2d* pts, float tol)
+{
+    // Wang公式: 等分n段的误差不超过 d(d-1)/8 * M / n^2, 三次曲线 d=3
+    float m1 = (pts[0].asVector() - 2.f * pts[1].asVector() + pts[2].asVector()).length();
+    float m2 = (pts[1].asVector() - 2.f * pts[2].asVector() + pts[3].asVector()).length();
+    float d = 0.75f * mgMax(m1, m2);
+
+    if (d <= tol || tol < _MGZERO)
+        return 1;
+    return mgMin((Int32)ceilf(sqrtf(d / tol)), (Int32)1024);
+}
+
+GEOMAPI Int32 mgFlattenBeziers(Int32 count, const Point2d* pts, float tol, 
+                               Point2d* lines, Int32 maxCount)
+{
+    if (count < 4 || !pts)
+        return 0;
+    if (!lines)
+        maxCount = 0;
+
+    Int32 n = 1;
+    if (maxCount > 0)
+        lines[0] = pts[0];
+
+    for (Int32 i = 0; i + 3 < count; i += 3)
+    {
+        Int32 segs = mgBezierSegments(pts + i, tol);
+        for (Int32 j = 1; j <= segs; j++, n++)
+        {
+            if (n >= maxCount)
+                continue;
+            if (j == segs)
+                lines[n] = pts[i + 3];          // 端点精确
+            else
+                mgFitBezier(pts + i, (float)j / segs, lines[n]);
+        }
+    }
+
+    return n;
+}
+
 GEOMAPI void mgBezier4P(
     const Point2d& pt1, const Point2d& pt2, const Point2d& pt3, 
     const Point2d& pt4, Point2d& ctrpt1, Point2d& ctrpt2)
@@ -3,6 +3,7 @@
 // License: LGPL, https://github.com/rhcad/touchvg
 
 #include "mglnrel.h"
+#include <vector>
 
 // 判断点pt是否在有向直线a->b的左边 (开区间)
 GEOMAPI bool mgIsLeft(const Point2d& a, const Point2d& b, const Point2d& pt)
@@ -431,7 +432,8 @@ GEOMAPI MgPtInAreaRet mgPtInArea(
         const Point2d& p2 = (i+1 < count) ? vertexs[i+1] : vertexs[0];
         
         // P在某条边上. 返回 kMgPtOnEdge, order = 边号 [0, count-1]
-        if (mgIsBetweenLine2(p1, p2, pt, tol))
+        // 跳过重合顶点间的零长度边，否则与P的X坐标无关都会判为共线
+        if (p1 != p2 && mgIsBetweenLine2(p1, p2, pt, tol))
         {
             order = i;
             return kMgPtOnEdge;
@@ -447,6 +449,136 @@ GEOMAPI MgPtInAreaRet mgPtInArea(
     return 0 == odd ? kMgPtInArea : kMgPtOutArea;
 }
 
+// 逐边判断多个点，内层循环对各点无分支，便于编译器向量化
+static void PtsInArea_Edges(Int32 n, const Point2d* pts, Int32 count, 
+                            const Point2d* vertexs, bool* inside)
+{
+    for (Int32 i = 0, j = count - 1; i < count; j = i++)
+    {
+        const float x1 = vertexs[i].x, y1 = vertexs[i].y;
+        const float y2 = vertexs[j].y;
+        
+        if (y1 == y2)       // 水平边与水平射线无交点
+            continue;
+        const float k = (vertexs[j].x - x1) / (y2 - y1);
+        
+        for (Int32 m = 0; m < n; m++)
+        {
+            const float x = pts[m].x, y = pts[m].y;
+            inside[m] ^= ((y1 > y) != (y2 > y)) & (x < x1 + (y - y1) * k);
+        }
+    }
+}
+
+// 将多边形的边按Y方向分段，每个点只与所在分段的边求交
+static void PtsInArea_Buckets(Int32 n, const Point2d* pts, Int32 count, 
+                              const Point2d* vertexs, bool* inside)
+{
+    const Box2d rect (count, vertexs);
+    const Int32 nb = mgMin(count / 4, (Int32)256);
+    const float h = (rect.ymax - rect.ymin) / nb;
+    std::vector<Int32> starts(nb + 1, 0);
+    std::vector<Int32> edges;
+    Int32 i, j, b, b1, b2;
+    
+    if (h < _MGZERO) {
+        PtsInArea_Edges(n, pts, count, vertexs, inside);
+        return;
+    }
+    for (int pass = 0; pass < 2; pass++)    // 先统计各段的边数，再填充边号
+    {
+        if (pass == 1) {
+            for (b = 0; b < nb; b++)
+                starts[b + 1] += starts[b];
+            edges.resize(starts[nb]);
+        }
+        std::vector<Int32> pos(starts.begin(), starts.end() - 1);
+        
+        for (i = 0, j = count - 1; i < count; j = i++)
+        {
+            if (vertexs[i].y == vertexs[j].y)
+                continue;
+            b1 = mgMin(nb - 1, (Int32)((mgMin(vertexs[i].y, vertexs[j].y) - rect.ymin) / h));
+            b2 = mgMin(nb - 1, (Int32)((mgMax(vertexs[i].y, vertexs[j].y) - rect.ymin) / h));
+            for (b = b1; b <= b2; b++) {
+                if (pass == 0)
+                    starts[b + 1]++;
+                else
+                    edges[pos[b]++] = i;
+            }
+        }
+    }
+    
+    for (Int32 m = 0; m < n; m++)
+    {
+        const float x = pts[m].x, y = pts[m].y;
+        bool odd = false;
+        
+        if (y >= rect.ymin && y <= rect.ymax)
+        {
+            b = mgMin(nb - 1, (Int32)((y - rect.ymin) / h));
+            for (Int32 e = starts[b]; e < starts[b + 1]; e++)
+            {
+                i = edges[e];
+                const Point2d& p1 = vertexs[i];
+                const Point2d& p2 = vertexs[i > 0 ? i - 1 : count - 1];
+                odd ^= ((p1.y > y) != (p2.y > y))
+                    & (x < p1.x + (y - p1.y) * (p2.x - p1.x) / (p2.y - p1.y));
+            }
+        }
+        inside[m] = odd;
+    }
+}
+
+GEOMAPI Int32 mgPtsInArea(
+    Int32 n, const Point2d* pts, Int32 count, const Point2d* vertexs, bool* inside)
+{
+    Int32 m, ret = 0;
+    
+    for (m = 0; m < n; m++)
+        inside[m] = false;
+    if (count < 3 || n < 1)
+        return 0;
+    
+    if (count >= 64 && n >= 8)      // 分段的开销可由多个点分摊
+        PtsInArea_Buckets(n, pts, count, vertexs, inside);
+    else
+        PtsInArea_Edges(n, pts, count, vertexs, inside);
+    
+    for (m = 0; m < n; m++)
+        ret += inside[m] ? 1 : 0;
+    
+    return ret;
+}
+
+GEOMAPI Int32 mgPtInAreas(
+    const Point2d& pt, Int32 polyCount, const Int32* starts, 
+    const Point2d* vertexs, const Box2d* extents, bool* inside)
+{
+    Int32 ret = 0;
+    
+    for (Int32 p = 0; p < polyCount; p++)
+    {
+        const Point2d* vs = vertexs + starts[p];
+        const Int32 count = starts[p + 1] - starts[p];
+        bool odd = false;
+        
+        if (count > 2 && (!extents || extents[p].contains(pt)))
+        {
+            for (Int32 i = 0, j = count - 1; i < count; j = i++)
+            {
+                const float y1 = vs[i].y, y2 = vs[j].y;
+                odd ^= ((y1 > pt.y) != (y2 > pt.y))
+                    && (pt.x < vs[i].x + (pt.y - y1) * (vs[j].x - vs[i].x) / (y2 - y1));
+            }
+        }
+        inside[p] = odd;
+        ret += odd ? 1 : 0;
+    }
+    
+    return ret;
+}
+
 // 判断多边形是否为凸多边形
 GEOMAPI bool mgIsConvex(Int32 count, const Point2d* vs, bool* pACW)
 {
@@ -84,6 +84,16 @@ GEOMAPI bool mgCubicSplinesIntersectBox(
     return false;
 }
 
+// 点到线段的距离，不用容差判断，用于折线化后的快速排除
+static float distanceToSegment(const Point2d& a, const Point2d& b, const Point2d& pt)
+{
+    Vector2d v (b - a);
+    Vector2d w (pt - a);
+    float len2 = v.lengthSqrd();
+    float t = len2 > 0 ? mgMax(0.f, mgMin(1.f, v.dotProduct(w) / len2)) : 0.f;
+    return (w - v * t).length();
+}
+
 GEOMAPI float mgCubicSplinesHit(
     Int32 n, const Point2d* knots, const Vector2d* knotvs, bool closed, 
     const Point2d& pt, float tol, Point2d& nearpt, Int32& segment)
@@ -94,12 +104,26 @@ GEOMAPI float mgCubicSplinesHit(
     const Box2d rect (pt, 2 * tol, 2 * tol);
     Int32 n2 = (closed && n > 1) ? n + 1 : n;
 
+    const float ftol = tol * 0.5f;      // 折线化误差
+    Point2d lines[33];
+
     segment = -1;
     for (Int32 i = 0; i + 1 < n2; i++)
     {
         mgCubicSplineToBezier(n, knots, knotvs, i, pts);
         if (rect.isIntersect(computeCubicBox(pts)))
         {
+            // 曲线上各点与折线的距离不超过ftol，离折线较远时曲线也必然较远
+            Int32 nl = mgFlattenBeziers(4, pts, ftol, lines, 33);
+            if (nl <= 33)
+            {
+                dDist = _FLT_MAX;
+                for (Int32 j = 0; j + 1 < nl; j++)
+                    dDist = mgMin(dDist, distanceToSegment(lines[j], lines[j+1], pt));
+                if (dDist - ftol > mgMin(tol, dDistMin))
+                    continue;
+            }
+            
             mgNearestOnBezier(pt, pts, ptTemp);
             dDist = pt.distanceTo(ptTemp);
             if (dDist <= tol && dDist < dDistMin)
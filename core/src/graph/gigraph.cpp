@@ -15,10 +15,12 @@
 GiGraphics::GiGraphics(GiTransform* xform)
 {
     m_impl = new GiGraphicsImpl(xform);
+    m_impl->polygonClip = new PolygonClip();
 }
 
 GiGraphics::~GiGraphics()
 {
+    delete m_impl->polygonClip;
     delete m_impl;
 }
 
@@ -55,7 +57,8 @@ void GiGraphics::_beginPaint(const RECT_2D& clipBox)
         m_impl->zoomChanged();
         m_impl->lastZoomTimes = xf().getZoomTimes();
     }
-    giInterlockedIncrement(&m_impl->drawRefcnt);
+    if (giInterlockedIncrement(&m_impl->drawRefcnt) == 1 && m_impl->stats)
+        m_impl->stats->beginFrame();
 
     if (!Box2d(clipBox).isEmpty())
     {
@@ -72,12 +75,13 @@ void GiGraphics::_beginPaint(const RECT_2D& clipBox)
 
 void GiGraphics::_endPaint()
 {
-    giInterlockedDecrement(&m_impl->drawRefcnt);
+    if (giInterlockedDecrement(&m_impl->drawRefcnt) == 0 && m_impl->stats)
+        m_impl->stats->endFrame();
 }
 
 bool GiGraphics::isDrawing() const
 {
-    return m_impl->drawRefcnt > 0;
+    return giAtomicLoad(&m_impl->drawRefcnt) > 0;
 }
 
 bool GiGraphics::isPrint() const
@@ -85,6 +89,16 @@ bool GiGraphics::isPrint() const
     return m_impl->isPrint;
 }
 
+void GiGraphics::setStats(GiDrawStats* stats)
+{
+    m_impl->stats = stats;
+}
+
+GiDrawStats* GiGraphics::getStats() const
+{
+    return m_impl->stats;
+}
+
 GiCanvas* GiGraphics::getCanvas()
 {
     return m_impl->canvas;
@@ -267,6 +281,24 @@ static inline const Box2d& DRAW_MAXR(const GiGraphicsImpl* p, bool modelUnit)
     return modelUnit ? p->rectDrawMaxM : p->rectDrawMaxW;
 }
 
+static inline void STATS_RAW(const GiGraphicsImpl* p, int vertexes, int calls = 1)
+{
+    if (p->stats)
+        p->stats->addRaw(vertexes, calls);
+}
+
+static inline void STATS_DROPPED(GiDrawStats* stats, int n)
+{
+    if (stats)
+        stats->addDropped(n);
+}
+
+static inline void STATS_CLIPPED(GiDrawStats* stats, int n)
+{
+    if (stats)
+        stats->addClipped(n);
+}
+
 bool GiGraphics::drawLine(const GiContext* ctx, 
                           const Point2d& startPt, const Point2d& endPt, 
                           bool modelUnit)
@@ -274,6 +306,7 @@ bool GiGraphics::drawLine(const GiContext* ctx,
     if (m_impl->drawRefcnt == 0)
         return false;
     GiLock lock (&m_impl->drawRefcnt);
+    GiStatsScope scope (m_impl->stats, GiDrawStats::kLine, 2);
 
     if (!DRAW_RECT(m_impl, modelUnit).isIntersect(Box2d(startPt, endPt)))
         return false;
@@ -300,6 +333,10 @@ public:
     {
         return pxs && n > 1 && m_gs->rawLines(m_pContext, pxs, n);
     }
+    void dropped(int n) const
+    {
+        STATS_DROPPED(m_gs->getStats(), n);
+    }
 };
 
 static bool DrawEdge(int count, int &i, Point2d* pts, Point2d &ptLast, 
@@ -358,6 +395,7 @@ static bool DrawEdge(int count, int &i, Point2d* pts, Point2d &ptLast,
                 pxs[n++] = pt1;
             }
         }
+        aux.dropped(ei - si + 1 - n);
 
         return aux.draw(pxs, n);
     }
@@ -373,6 +411,7 @@ bool GiGraphics::drawLines(const GiContext* ctx, int count,
     if (count > 0x2000)
         count = 0x2000;
     GiLock lock (&m_impl->drawRefcnt);
+    GiStatsScope scope (m_impl->stats, GiDrawStats::kLines, count);
 
     int i;
     Point2d pt1, pt2, ptLast;
@@ -399,10 +438,12 @@ bool GiGraphics::drawLines(const GiContext* ctx, int count,
                 pxs[n++] = pt2;
             }
         }
+        STATS_DROPPED(m_impl->stats, count - n);
         ret = rawLines(ctx, pxs, n);
     }
     else                                            // 部分在显示区域内
     {
+        STATS_CLIPPED(m_impl->stats, count);
         pointBuf.resize(count);
         for (i = 0; i < count; i++)                 // 转换到像素坐标
             pointBuf[i] = points[i] * matD;
@@ -419,12 +460,80 @@ bool GiGraphics::drawLines(const GiContext* ctx, int count,
     return ret;
 }
 
+bool GiGraphics::drawLinesBatch(const GiContext* ctx, int lineCount, 
+                                const int* counts, const Point2d* points, bool modelUnit)
+{
+    if (m_impl->drawRefcnt == 0 || lineCount < 1 || counts == NULL || points == NULL)
+        return false;
+    GiLock lock (&m_impl->drawRefcnt);
+    GiStatsScope scope (m_impl->stats, GiDrawStats::kLinesBatch);
+
+    vector<Point2d> pxpoints;
+    vector<int> pxcounts;
+    bool ret = false;
+    Matrix2d matD(S2D(xf(), modelUnit));
+    int total = 0;
+
+    for (int k = 0; k < lineCount; k++)
+        total += counts[k];
+    pxpoints.reserve(total + lineCount);
+    pxcounts.reserve(lineCount);
+
+    for (int k = 0; k < lineCount; points += counts[k++])
+    {
+        const int count = counts[k];
+        if (count < 2)
+            continue;
+
+        const Box2d extent (count, points);
+        const bool visible = DRAW_RECT(m_impl, modelUnit).isIntersect(extent);
+        if (visible && (!DRAW_MAXR(m_impl, modelUnit).contains(extent) || count > 0x2000))
+        {
+            ret = drawLines(ctx, count, points, modelUnit) || ret;  // 顶点数计入 lines
+            continue;
+        }
+        if (m_impl->stats)
+            m_impl->stats->addVertexes(count);
+        if (!visible)
+            continue;
+
+        Point2d pt1, pt2;
+        int n = 0;
+        for (int i = 0; i < count; i++)             // 与 drawLines 相同地去掉过近的点
+        {
+            pt2 = points[i] * matD;
+            if (i == 0 || fabs(pt1.x - pt2.x) > 2 || fabs(pt1.y - pt2.y) > 2)
+            {
+                pt1 = pt2;
+                pxpoints.push_back(pt2);
+                n++;
+            }
+        }
+        if (n == 1)                                 // 很短的折线也至少保留两点，画布才会显示
+        {
+            pxpoints.push_back(pt2);
+            n++;
+        }
+        STATS_DROPPED(m_impl->stats, count - n);
+        pxcounts.push_back(n);
+    }
+
+    if (!pxcounts.empty())
+    {
+        ret = rawLinesBatch(ctx, getSize(pxcounts), &pxcounts.front(),
+                            &pxpoints.front()) || ret;
+    }
+
+    return ret;
+}
+
 bool GiGraphics::drawBeziers(const GiContext* ctx, int count, 
                              const Point2d* points, bool closed, bool modelUnit)
 {
     if (m_impl->drawRefcnt == 0 || count < 4 || points == NULL)
         return false;
     GiLock lock (&m_impl->drawRefcnt);
+    GiStatsScope scope (m_impl->stats, GiDrawStats::kBeziers, count);
     if (count > 0x2000)
         count = 0x2000;
     count = 1 + (count - 1) / 3 * 3;
@@ -464,6 +573,7 @@ bool GiGraphics::drawBeziers(const GiContext* ctx, int count,
     }
     else
     {        
+        STATS_CLIPPED(m_impl->stats, count);
         pointBuf.resize(count);
         for (i = 0; i < count; i++)                 // 转换到像素坐标
             pointBuf[i] = points[i] * matD;
@@ -498,6 +608,7 @@ bool GiGraphics::drawArc(const GiContext* ctx,
     if (m_impl->drawRefcnt == 0 || rx < _MGZERO || fabs(sweepAngle) < 1e-5f)
         return false;
     GiLock lock (&m_impl->drawRefcnt);
+    GiStatsScope scope (m_impl->stats, GiDrawStats::kArc);
 
     if (ry < _MGZERO)
         ry = rx;
@@ -561,6 +672,7 @@ static bool drawPolygonEdge(const PolylineAux& aux,
                     pxs[n++] = pt1;
                 }
             }
+            aux.dropped(ei - si + 1 - n);
 
             ret = aux.draw(pxs, n) || ret;
         }
@@ -606,14 +718,20 @@ static bool _DrawPolygon(GiCanvas* cv, const GiContext* ctx,
             pxs[n++] = pt1;
         }
     }
+    GiDrawStats* stats = cv->gs()->getStats();
+    STATS_DROPPED(stats, count - n);
 
     if (n == 4 && mgIsZero(pxs[0].x - pxs[3].x) && mgIsZero(pxs[1].x - pxs[2].x)
         && mgIsZero(pxs[0].y - pxs[1].y) && mgIsZero(pxs[2].y - pxs[3].y))
     {
+        if (stats)
+            stats->addRaw(4);
         return cv->rawRect(&context, pxs[0].x, pxs[0].y, 
             pxs[2].x - pxs[0].x, pxs[2].y - pxs[0].y);
     }
 
+    if (stats)
+        stats->addRaw(n);
     return cv->rawPolygon(&context, pxs, n);
 }
 
@@ -623,6 +741,7 @@ bool GiGraphics::drawPolygon(const GiContext* ctx, int count,
     if (m_impl->drawRefcnt == 0 || count < 2 || points == NULL)
         return false;
     GiLock lock (&m_impl->drawRefcnt);
+    GiStatsScope scope (m_impl->stats, GiDrawStats::kPolygon, count);
     if (count > 0x2000)
         count = 0x2000;
 
@@ -639,7 +758,9 @@ bool GiGraphics::drawPolygon(const GiContext* ctx, int count,
     }
     else                                                // 部分在显示区域内
     {
-        PolygonClip clip (m_impl->rectDraw);
+        STATS_CLIPPED(m_impl->stats, count);
+        PolygonClip& clip = *m_impl->polygonClip;
+        clip.setRect(m_impl->rectDraw);
         if (!clip.clip(count, points, &S2D(xf(), modelUnit)))  // 多边形剪裁
             return false;
         count = clip.getCount();
@@ -674,6 +795,7 @@ bool GiGraphics::drawEllipse(const GiContext* ctx, const Point2d& center,
     if (m_impl->drawRefcnt == 0 || rx < _MGZERO)
         return false;
     GiLock lock (&m_impl->drawRefcnt);
+    GiStatsScope scope (m_impl->stats, GiDrawStats::kEllipse);
     bool ret = false;
     Matrix2d matD(S2D(xf(), modelUnit));
 
@@ -719,6 +841,7 @@ bool GiGraphics::drawPie(const GiContext* ctx,
     if (m_impl->drawRefcnt == 0 || rx < _MGZERO || fabs(sweepAngle) < 1e-5f)
         return false;
     GiLock lock (&m_impl->drawRefcnt);
+    GiStatsScope scope (m_impl->stats, GiDrawStats::kPie);
 
     if (ry < _MGZERO)
         ry = rx;
@@ -765,6 +888,7 @@ bool GiGraphics::drawRoundRect(const GiContext* ctx,
     if (m_impl->drawRefcnt == 0 || rect.isEmpty())
         return false;
     GiLock lock (&m_impl->drawRefcnt);
+    GiStatsScope scope (m_impl->stats, GiDrawStats::kRoundRect);
     bool ret = false;
 
     if (ry < _MGZERO)
@@ -819,6 +943,7 @@ bool GiGraphics::drawSplines(const GiContext* ctx, int count,
         || knots == NULL || knotvs == NULL)
         return false;
     GiLock lock (&m_impl->drawRefcnt);
+    GiStatsScope scope (m_impl->stats, GiDrawStats::kSplines, count);
     count = mgMin(count, static_cast<int>(1 + (0x2000 - 1) / 3));
 
     int i;
@@ -856,6 +981,7 @@ bool GiGraphics::drawClosedSplines(const GiContext* ctx, int count,
         knots == NULL || knotvs == NULL)
         return false;
     GiLock lock (&m_impl->drawRefcnt);
+    GiStatsScope scope (m_impl->stats, GiDrawStats::kSplines, count);
     count = mgMin(count, static_cast<int>((0x2000 - 1) / 3));
 
     int i, j = 0;
@@ -902,6 +1028,7 @@ bool GiGraphics::drawBSplines(const GiContext* ctx, int count,
     if (m_impl->drawRefcnt == 0 || count < 4 || ctlpts == NULL)
         return false;
     GiLock lock (&m_impl->drawRefcnt);
+    GiStatsScope scope (m_impl->stats, GiDrawStats::kBSplines, count);
     count = mgMin(count, static_cast<int>(3 + (0x2000 - 1) / 3));
 
     const Box2d extent (count, ctlpts);              // 模型坐标范围
@@ -952,6 +1079,7 @@ bool GiGraphics::drawClosedBSplines(const GiContext* ctx,
     if (m_impl->drawRefcnt == 0 || count < 3 || ctlpts == NULL)
         return false;
     GiLock lock (&m_impl->drawRefcnt);
+    GiStatsScope scope (m_impl->stats, GiDrawStats::kBSplines, count);
     count = mgMin(count, static_cast<int>((0x2000 - 1) / 3));
 
     const Box2d extent (count, ctlpts);              // 模型坐标范围
@@ -1012,6 +1140,7 @@ bool GiGraphics::drawPath(const GiContext* ctx, int count,
         || points == NULL || types == NULL)
         return false;
     GiLock lock (&m_impl->drawRefcnt);
+    GiStatsScope scope (m_impl->stats, GiDrawStats::kPath, count);
     if (count > 0x2000)
         count = 0x2000;
 
@@ -1054,37 +1183,44 @@ float GiGraphics::getScreenDpi() const
 
 bool GiGraphics::rawLine(const GiContext* ctx, float x1, float y1, float x2, float y2)
 {
+    STATS_RAW(m_impl, 2);
     return m_impl->canvas && m_impl->canvas->rawLine(ctx, x1, y1, x2, y2);
 }
 
 bool GiGraphics::rawLines(const GiContext* ctx, const Point2d* pxs, int count)
 {
+    STATS_RAW(m_impl, count);
     return m_impl->canvas && m_impl->canvas->rawLines(ctx, pxs, count);
 }
 
 bool GiGraphics::rawBeziers(const GiContext* ctx, const Point2d* pxs, int count)
 {
+    STATS_RAW(m_impl, count);
     return m_impl->canvas && m_impl->canvas->rawBeziers(ctx, pxs, count);
 }
 
 bool GiGraphics::rawPolygon(const GiContext* ctx, const Point2d* pxs, int count)
 {
+    STATS_RAW(m_impl, count);
     return m_impl->canvas && m_impl->canvas->rawPolygon(ctx, pxs, count);
 }
 
 bool GiGraphics::rawRect(const GiContext* ctx, float x, float y, float w, float h)
 {
+    STATS_RAW(m_impl, 4);
     return m_impl->canvas && m_impl->canvas->rawRect(ctx, x, y, w, h);
 }
 
 bool GiGraphics::rawEllipse(const GiContext* ctx, float x, float y, float w, float h)
 {
+    STATS_RAW(m_impl, 0);
     return m_impl->canvas && m_impl->canvas->rawEllipse(ctx, x, y, w, h);
 }
 
 bool GiGraphics::rawPath(const GiContext* ctx, int count, 
                          const Point2d* pxs, const UInt8* types)
 {
+    STATS_RAW(m_impl, count);
     return m_impl->canvas && m_impl->canvas->rawPath(ctx, count, pxs, types);
 }
 
@@ -1095,21 +1231,25 @@ bool GiGraphics::rawBeginPath()
 
 bool GiGraphics::rawEndPath(const GiContext* ctx, bool fill)
 {
+    STATS_RAW(m_impl, 0);
     return m_impl->canvas && m_impl->canvas->rawEndPath(ctx, fill);
 }
 
 bool GiGraphics::rawMoveTo(float x, float y)
 {
+    STATS_RAW(m_impl, 1, 0);
     return m_impl->canvas && m_impl->canvas->rawMoveTo(x, y);
 }
 
 bool GiGraphics::rawLineTo(float x, float y)
 {
+    STATS_RAW(m_impl, 1, 0);
     return m_impl->canvas && m_impl->canvas->rawLineTo(x, y);
 }
 
 bool GiGraphics::rawBezierTo(const Point2d* pxs, int count)
 {
+    STATS_RAW(m_impl, count, 0);
     return m_impl->canvas && m_impl->canvas->rawBezierTo(pxs, count);
 }
 
@@ -1117,3 +1257,27 @@ bool GiGraphics::rawClosePath()
 {
     return m_impl->canvas && m_impl->canvas->rawClosePath();
 }
+
+bool GiGraphics::rawLinesBatch(const GiContext* ctx, int lineCount, 
+                               const int* counts, const Point2d* pxs)
+{
+    if (m_impl->stats) {
+        int n = 0;
+        for (int i = 0; i < lineCount; i++)
+            n += counts[i];
+        m_impl->stats->addRaw(n);
+    }
+    return m_impl->canvas && m_impl->canvas->rawLinesBatch(ctx, lineCount, counts, pxs);
+}
+
+bool GiGraphics::rawBeziersBatch(const GiContext* ctx, int curveCount, 
+                                 const int* counts, const Point2d* pxs)
+{
+    if (m_impl->stats) {
+        int n = 0;
+        for (int i = 0; i < curveCount; i++)
+            n += counts[i];
+        m_impl->stats->addRaw(n);
+    }
+    return m_impl->canvas && m_impl->canvas->rawBeziersBatch(ctx, curveCount, counts, pxs);
+}
@@ -16,25 +16,63 @@ template<class T> inline static int getSize(T& arr)
 }
 
 //! 多边形剪裁类
+/*! 剪裁区域为显示坐标系中的矩形，由四条边界线组成。先用顶点的区域编码整体判断
+    全在区域内外的情况，部分在区域内时只对有顶点越过的边界线逐条剪裁。
+    剪裁缓冲在多次剪裁间保留，可由绘图对象长期持有以避免反复分配内存。
+*/
 class PolygonClip
 {
-    const Box2d     m_rect;         //!< 剪裁矩形
+private:
+    struct Edge {                   //!< 剪裁边界线，nx*x+ny*y+c >= 0 为可见侧
+        float       nx, ny, c;
+    };
+
+    Box2d           m_rect;         //!< 剪裁矩形
+    Edge            m_edges[4];     //!< 剪裁边界线
+    int             m_edgeCount;    //!< 剪裁边界线数
+    bool            m_closed;       //!< 是否闭合
+    vector<Point2d> m_input;        //!< 坐标变换后的顶点缓冲
     vector<Point2d> m_vs1;          //!< 剪裁交点缓冲
     vector<Point2d> m_vs2;          //!< 剪裁交点缓冲
-    bool            m_closed;       //!< 是否闭合
-    
+    const Point2d*  m_result;       //!< 剪裁结果中的顶点数组
+    int             m_count;        //!< 剪裁结果中的顶点个数
+
 public:
-    
+
     //! 构造函数
     /*!
         \param rect 剪裁矩形，必须为规范化的矩形
         \param closed 将要传入的坐标序列是多边形还是折线
     */
     PolygonClip(const Box2d& rect, bool closed = true)
-        : m_rect(rect), m_closed(closed)
     {
+        setRect(rect, closed);
     }
-    
+
+    //! 默认构造函数，需要再调用 setRect 设置剪裁区域
+    PolygonClip() : m_edgeCount(0), m_closed(true), m_result(NULL), m_count(0)
+    {
+    }
+
+    //! 设置剪裁矩形，保留已分配的剪裁缓冲
+    /*!
+        \param rect 剪裁矩形，必须为规范化的矩形
+        \param closed 将要传入的坐标序列是多边形还是折线
+    */
+    void setRect(const Box2d& rect, bool closed = true)
+    {
+        m_rect = rect;
+        m_closed = closed;
+        m_result = NULL;
+        m_count = 0;
+
+        m_edgeCount = 4;                // 依次为 LEFT, TOP, RIGHT, BOTTOM
+        setEdge(0,  1.f,  0.f, -rect.xmin);
+        setEdge(1,  0.f,  1.f, -rect.ymin);
+        setEdge(2, -1.f,  0.f,  rect.xmax);
+        setEdge(3,  0.f, -1.f,  rect.ymax);
+    }
+
     //! 剪裁一个多边形
     /*!
         \param count 顶点个数
@@ -44,48 +82,64 @@ public:
     */
     bool clip(int count, const Point2d* points, const Matrix2d* mat = NULL)
     {
-        if (count < 2 || points == NULL)
+        m_result = NULL;
+        m_count = 0;
+
+        if (count < 2 || points == NULL || m_edgeCount < 1)
             return false;
-        
+
         if (mat != NULL)
         {
-            m_vs1.resize(2+count/2);
-            m_vs2.resize(count);
-            Point2d* p = &m_vs2.front();
+            m_input.resize(count);
+            Point2d* p = &m_input.front();
             for (int i=0; i < count; i++)
                 p[i] = points[i] * (*mat);
             points = p;
         }
-        else
+
+        unsigned int andCode = ~0u;
+        unsigned int orCode = 0;
+
+        for (int i=0; i < count; i++)
         {
-            m_vs1.resize(2+count/2);
-            m_vs2.resize(2+count/2);
+            unsigned int code = outcode(points[i]);
+            andCode &= code;
+            orCode |= code;
         }
-        if (!clipEdge(m_vs1, count, points, LEFT) ||
-            !clipEdge(m_vs2, getSize(m_vs1), &m_vs1.front(), TOP) ||
-            !clipEdge(m_vs1, getSize(m_vs2), &m_vs2.front(), RIGHT) ||
-            !clipEdge(m_vs2, getSize(m_vs1), &m_vs1.front(), BOTTOM))
-        {
+        if (andCode != 0)               // 全部在某条边界线外
             return false;
+
+        vector<Point2d>* arr = &m_vs1;
+
+        for (int e = 0; e < m_edgeCount && orCode != 0; e++)
+        {
+            if ((orCode & (1u << e)) == 0)  // 没有顶点越过该边界线
+                continue;
+            if (!clipEdge(*arr, count, points, m_edges[e]))
+                return false;
+            count = getSize(*arr);
+            points = &arr->front();
+            arr = (arr == &m_vs1) ? &m_vs2 : &m_vs1;
         }
 
-        m_vs1.clear();
+        m_result = points;
+        m_count = count;
 
         return true;
     }
-    
+
     //! 返回剪裁结果中的顶点个数
     int getCount() const
     {
-        return getSize(m_vs2);
+        return m_count;
     }
-    
+
     //! 返回剪裁结果中的顶点数组
     const Point2d* getPoints() const
     {
-        return &m_vs2.front();
+        return m_result;
     }
-    
+
     //! 返回剪裁结果中的指定序号的顶点坐标
     /*!
         \param index 顶点的序号, >=0, 自动取到顶点个数范围内
@@ -93,12 +147,12 @@ public:
     */
     const Point2d& getPoint(int index) const
     {
-        return m_vs2[index % m_vs2.size()];
+        return m_result[index % m_count];
     }
-    
+
     //! 判断剪裁后两相邻顶点是否构成轮廓边
     /*!
-        \param index 剪裁后的边(可见或不可见的)的序号, 自动取到[0, getCount()-1]范围内, 
+        \param index 剪裁后的边(可见或不可见的)的序号, 自动取到[0, getCount()-1]范围内,
             为( getCount()-1 )时相当于是首尾顶点的连线
         \return 该边是否构成轮廓边, 即可见边
     */
@@ -106,110 +160,87 @@ public:
     {
         const Point2d& p1 = getPoint(index);
         const Point2d& p2 = getPoint(index+1);
-        
-        // 和剪裁边重合
-        if (mgIsZero(p1.x - p2.x) && (mgIsZero(p1.x - m_rect.xmin) || mgIsZero(p1.x - m_rect.xmax)))
-            return false;
-        if (mgIsZero(p1.y - p2.y) && (mgIsZero(p1.y - m_rect.ymin) || mgIsZero(p1.y - m_rect.ymax)))
-            return false;
+
+        // 和剪裁边重合，交点坐标是精确的
+        for (int e = 0; e < m_edgeCount; e++)
+        {
+            if (fabs(distance(m_edges[e], p1)) < _MGZERO
+                && fabs(distance(m_edges[e], p2)) < _MGZERO)
+            {
+                return false;
+            }
+        }
 
         return true;
     }
-    
-private:
-    
-    void operator=(const PolygonClip&);
-
-    enum kSideType { LEFT, TOP, RIGHT, BOTTOM };
-    
-    bool clipEdge(vector<Point2d>& arr, int count, const Point2d* points, kSideType side)
-    {
-        if (count < 2 || points == NULL)
-            return false;
 
-        arr.clear();
-        output(arr, points[m_closed ? count-1 : 0], points[0], side);
+private:
 
-        for (int i=1; i < count; i++)
-        {
-            output(arr, points[i-1], points[i], side);
-        }
+    PolygonClip(const PolygonClip&);
+    void operator=(const PolygonClip&);
 
-        return (arr.size() >= 2);
-    }
-    
-    void output(vector<Point2d>& arr, const Point2d& p1, const Point2d& p2, kSideType side)
+    void setEdge(int index, float nx, float ny, float c)
     {
-        switch (side)
-        {
-        case LEFT:      clipLeft(arr, p1, p2); break;
-        case TOP:       clipTop(arr, p1, p2); break;
-        case RIGHT:     clipRight(arr, p1, p2); break;
-        case BOTTOM:    clipBottom(arr, p1, p2); break;
-        }
+        m_edges[index].nx = nx;
+        m_edges[index].ny = ny;
+        m_edges[index].c = c;
     }
-    
-    void clipLeft(vector<Point2d>& arr, const Point2d& p1, const Point2d& p2)
+
+    static float distance(const Edge& edge, const Point2d& pt)
     {
-        float y;
-        
-        // 如果线段与剪裁线相交，则输出交点
-        if ((p1.x < m_rect.xmin) != (p2.x < m_rect.xmin))
-        {
-            y = p1.y + (m_rect.xmin - p1.x) * (p2.y - p1.y) / (p2.x - p1.x);
-            arr.push_back(Point2d(m_rect.xmin, y));
-        }
-        
-        // 如果终点在可见侧，则输出终点
-        if (p2.x >= m_rect.xmin)
-        {
-            arr.push_back(p2);
-        }
+        return edge.nx * pt.x + edge.ny * pt.y + edge.c;
     }
-    
-    void clipTop(vector<Point2d>& arr, const Point2d& p1, const Point2d& p2)
+
+    // 区域编码，第i位表示在第i条边界线外，无分支比较，便于编译器向量化
+    unsigned int outcode(const Point2d& pt) const
     {
-        float x;
-        
-        if ((p1.y < m_rect.ymin) != (p2.y < m_rect.ymin))
-        {
-            x = p1.x + (m_rect.ymin - p1.y) * (p2.x - p1.x) / (p2.y - p1.y);
-            arr.push_back(Point2d(x, m_rect.ymin));
-        }
-        if (p2.y >= m_rect.ymin)
-        {
-            arr.push_back(p2);
-        }
+        return (unsigned int)(pt.x < m_rect.xmin)
+            | ((unsigned int)(pt.y < m_rect.ymin) << 1)
+            | ((unsigned int)(pt.x > m_rect.xmax) << 2)
+            | ((unsigned int)(pt.y > m_rect.ymax) << 3);
     }
-    
-    void clipRight(vector<Point2d>& arr, const Point2d& p1, const Point2d& p2)
+
+    bool clipEdge(vector<Point2d>& arr, int count, const Point2d* points, const Edge& edge)
     {
-        float y;
-        
-        if ((p1.x > m_rect.xmax) != (p2.x > m_rect.xmax))
-        {
-            y = p1.y + (m_rect.xmax - p1.x) * (p2.y - p1.y) / (p2.x - p1.x);
-            arr.push_back(Point2d(m_rect.xmax, y));
-        }
-        if (p2.x <= m_rect.xmax)
+        const Point2d* p1 = &points[m_closed ? count-1 : 0];
+        float d1 = distance(edge, *p1);
+
+        arr.clear();
+
+        for (int i=0; i < count; i++)
         {
-            arr.push_back(p2);
+            const Point2d& p2 = points[i];
+            float d2 = distance(edge, p2);
+
+            // 如果线段与剪裁线相交，则输出交点
+            if ((d1 < 0) != (d2 < 0))
+            {
+                arr.push_back(intersect(edge, *p1, p2, d1 / (d1 - d2)));
+            }
+
+            // 如果终点在可见侧，则输出终点
+            if (d2 >= 0)
+            {
+                arr.push_back(p2);
+            }
+            p1 = &p2;
+            d1 = d2;
         }
+
+        return (arr.size() >= 2);
     }
-    
-    void clipBottom(vector<Point2d>& arr, const Point2d& p1, const Point2d& p2)
+
+    static Point2d intersect(const Edge& edge, const Point2d& p1, const Point2d& p2, float t)
     {
-        float x;
-        
-        if ((p1.y > m_rect.ymax) != (p2.y > m_rect.ymax))
-        {
-            x = p1.x + (m_rect.ymax - p1.y) * (p2.x - p1.x) / (p2.y - p1.y);
-            arr.push_back(Point2d(x, m_rect.ymax));
-        }
-        if (p2.y <= m_rect.ymax)
-        {
-            arr.push_back(p2);
-        }
+        Point2d pt (p1.x + (p2.x - p1.x) * t, p1.y + (p2.y - p1.y) * t);
+
+        // 水平或垂直的边界线直接取其坐标，使交点精确地落在边界线上
+        if (edge.ny == 0)
+            pt.x = -edge.c / edge.nx;
+        else if (edge.nx == 0)
+            pt.y = -edge.c / edge.ny;
+
+        return pt;
     }
 };
 
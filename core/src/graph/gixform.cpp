@@ -3,6 +3,19 @@
 // License: LGPL, https://github.com/rhcad/touchvg
 
 #include "gixform.h"
+#include "gisync.h"
+
+struct GiTransformImpl;
+
+//! 在作用域内修改坐标系状态，只在一个线程中修改，其他线程可同时复制坐标系
+class GiXformWriting
+{
+public:
+    GiXformWriting(GiTransformImpl* impl);
+    ~GiXformWriting();
+private:
+    GiSeqLock&  _seqlock;
+};
 
 //! GiTransform的内部数据
 struct GiTransformImpl
@@ -32,10 +45,13 @@ struct GiTransformImpl
     float       minViewScale;   //!< 最小显示比例
     float       maxViewScale;   //!< 最大显示比例
     Box2d       rectLimitsW;    //!< 显示极限的世界坐标范围
+    double      originX;        //!< 世界坐标原点的绝对坐标X，默认0
+    double      originY;        //!< 世界坐标原点的绝对坐标Y，默认0
+    GiSeqLock   seqlock;        //!< 修改以上状态时递增，其他线程复制时不会读到改了一半的状态
 
     GiTransformImpl(bool _ydown)
         : cxWnd(1), cyWnd(1), dpiX(96), dpiY(96), ydown(_ydown), viewScale(1)
-        , zoomEnabled(true), tmpViewScale(1.f), zoomTimes(0)
+        , zoomEnabled(true), tmpViewScale(1.f), zoomTimes(0), originX(0), originY(0)
     {
         minViewScale = 0.01f;   // 最小显示比例为1%
         maxViewScale = 5.f;     // 最大显示比例为500%
@@ -50,19 +66,30 @@ struct GiTransformImpl
         w2dy = viewScale * dpiY / 25.4f;
 
         float wdy = ydown ? -w2dy : w2dy;
-        float xc = cxWnd * 0.5f;
-        float yc = cyWnd * 0.5f;
+        double xc = cxWnd * 0.5;
+        double yc = cyWnd * 0.5;
 
+        // 平移量按双精度计算后再取整为单精度，放大显示时减少抖动
         matD2W.set(1.f / w2dx, 0, 0, 1.f / wdy,
-            centerW.x - xc / w2dx, centerW.y - yc / wdy);
+            (float)(centerW.x - xc / w2dx), (float)(centerW.y - yc / wdy));
         matW2D.set(w2dx, 0, 0, wdy,
-            xc - w2dx * centerW.x, yc - wdy * centerW.y);
+            (float)(xc - (double)w2dx * centerW.x), (float)(yc - (double)wdy * centerW.y));
 
         matD2M = matD2W * matW2M;
         matM2D = matM2W * matW2D;
     }
 
+    //! 复制源对象的状态，源对象可能正在其他线程中放缩，读到修改中途的状态时重新复制
     void coptFrom(const GiTransformImpl* src)
+    {
+        long seq;
+        do {
+            seq = src->seqlock.beginRead();
+            copyState(src);
+        } while (src->seqlock.retryRead(seq));
+    }
+
+    void copyState(const GiTransformImpl* src)
     {
         cxWnd  = src->cxWnd;
         cyWnd  = src->cyWnd;
@@ -84,6 +111,8 @@ struct GiTransformImpl
         rectLimitsW = src->rectLimitsW;
         tmpCenterW = src->tmpCenterW;
         tmpViewScale = src->tmpViewScale;
+        originX = src->originX;
+        originY = src->originY;
     }
 
     void zoomChanged()
@@ -97,6 +126,7 @@ struct GiTransformImpl
 
         if (pnt != centerW || !mgIsZero(scale - viewScale))
         {
+            GiXformWriting writing (this);
             tmpCenterW = pnt;
             tmpViewScale = scale;
             bChanged = true;
@@ -117,6 +147,16 @@ struct GiTransformImpl
     bool zoomPanAdjust(Point2d &ptW, float dxPixel, float dyPixel) const;
 };
 
+GiXformWriting::GiXformWriting(GiTransformImpl* impl) : _seqlock(impl->seqlock)
+{
+    _seqlock.beginWrite();
+}
+
+GiXformWriting::~GiXformWriting()
+{
+    _seqlock.endWrite();
+}
+
 GiTransform::GiTransform(bool ydown)
 {
     m_impl = new GiTransformImpl(ydown);
@@ -135,8 +175,10 @@ GiTransform::~GiTransform()
 
 GiTransform& GiTransform::copy(const GiTransform& src)
 {
-    if (this != &src)
+    if (this != &src) {
+        GiXformWriting writing (m_impl);
         m_impl->coptFrom(src.m_impl);
+    }
     return *this;
 }
 
@@ -169,6 +211,38 @@ float GiTransform::getMaxViewScale() const
 Box2d GiTransform::getWorldLimits() const
     { return m_impl->rectLimitsW; }
 
+double GiTransform::getWorldOriginX() const
+    { return m_impl->originX; }
+double GiTransform::getWorldOriginY() const
+    { return m_impl->originY; }
+
+void GiTransform::setWorldOrigin(double x, double y)
+{
+    if (m_impl->originX != x || m_impl->originY != y)
+    {
+        Vector2d offset ((float)(m_impl->originX - x), (float)(m_impl->originY - y));
+        GiXformWriting writing (m_impl);
+
+        m_impl->originX = x;
+        m_impl->originY = y;
+        m_impl->centerW += offset;
+        m_impl->tmpCenterW += offset;
+        m_impl->updateTransforms();
+        m_impl->zoomChanged();
+    }
+}
+
+Point2d GiTransform::absoluteToWorld(double x, double y) const
+{
+    return Point2d((float)(x - m_impl->originX), (float)(y - m_impl->originY));
+}
+
+void GiTransform::worldToAbsolute(const Point2d& pntWorld, double& x, double& y) const
+{
+    x = m_impl->originX + pntWorld.x;
+    y = m_impl->originY + pntWorld.y;
+}
+
 float GiTransform::displayToModel(float px, bool mm) const
 {
     return mm ? (Vector2d(px,px) * m_impl->matW2M).length() * _M_SQRT1_2 / m_impl->viewScale
@@ -177,7 +251,7 @@ float GiTransform::displayToModel(float px, bool mm) const
 
 long GiTransform::getZoomTimes() const
 {
-    return m_impl->zoomTimes;
+    return giAtomicLoad(&m_impl->zoomTimes);
 }
 
 void GiTransform::setWndSize(long width, long height)
@@ -185,6 +259,7 @@ void GiTransform::setWndSize(long width, long height)
     if ((m_impl->cxWnd != width || m_impl->cyWnd != height)
         && width > 1 && height > 1)
     {
+        GiXformWriting writing (m_impl);
         m_impl->cxWnd = width;
         m_impl->cyWnd = height;
         m_impl->updateTransforms();
@@ -196,6 +271,7 @@ void GiTransform::setModelTransform(const Matrix2d& mat)
 {
     if (mat.isInvertible() && m_impl->matM2W != mat)
     {
+        GiXformWriting writing (m_impl);
         m_impl->matM2W = mat;
         m_impl->matW2M = m_impl->matM2W.inverse();
         m_impl->matD2M = m_impl->matD2W * m_impl->matW2M;
@@ -210,6 +286,7 @@ void GiTransform::setResolution(float dpiX, float dpiY)
     if (dpiX > 0.1f && dpiY > 0.1f 
         && (m_impl->dpiX != dpiX || m_impl->dpiY != dpiY))
     {
+        GiXformWriting writing (m_impl);
         m_impl->dpiX = dpiX;
         m_impl->dpiY = dpiY;
         m_impl->updateTransforms();
@@ -228,6 +305,7 @@ void GiTransform::setViewScaleRange(float minScale, float maxScale)
     maxScale = mgMax(maxScale, 1.f);
     maxScale = mgMin(maxScale, 50.f);
 
+    GiXformWriting writing (m_impl);
     m_impl->minViewScale = minScale;
     m_impl->maxViewScale = maxScale;
 }
@@ -235,6 +313,7 @@ void GiTransform::setViewScaleRange(float minScale, float maxScale)
 Box2d GiTransform::setWorldLimits(const Box2d& rect)
 {
     Box2d ret = m_impl->rectLimitsW;
+    GiXformWriting writing (m_impl);
     m_impl->rectLimitsW = rect;
     m_impl->rectLimitsW.normalize();
     return ret;
@@ -249,8 +328,12 @@ bool GiTransform::enableZoom(bool enabled)
 
 void GiTransform::getZoomValue(Point2d& centerW, float& viewScale) const
 {
-    centerW = m_impl->tmpCenterW;
-    viewScale = m_impl->tmpViewScale;
+    long seq;
+    do {
+        seq = m_impl->seqlock.beginRead();
+        centerW = m_impl->tmpCenterW;
+        viewScale = m_impl->tmpViewScale;
+    } while (m_impl->seqlock.retryRead(seq));
 }
 
 bool GiTransform::zoom(Point2d centerW, float viewScale, bool* changed)
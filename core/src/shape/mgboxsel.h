@@ -0,0 +1,211 @@
+//! \file mgboxsel.h
+//! \brief 定义增量框选辅助类 MgBoxSelector
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+
+#ifndef __GEOMETRY_MGBOXSELECTOR_H_
+#define __GEOMETRY_MGBOXSELECTOR_H_
+
+#include <mgshapes.h>
+#include <vector>
+
+//! 增量框选辅助类
+/*! 开始拖动时将图形范围放入均匀网格，每次拖动只检查进出新旧选择框之差的图形。
+    图形范围取自图形索引，只在相交选择时才载入需要检查的延迟载入图形。
+    \ingroup GEOM_SHAPE
+*/
+class MgBoxSelector
+{
+public:
+    MgBoxSelector() : m_shapes(NULL), m_changeCount(0), m_hasBox(false), m_intersect(false) {}
+
+    //! 返回是否已开始框选
+    bool started() const { return m_shapes != NULL; }
+
+    //! 结束框选
+    void end()
+    {
+        m_shapes = NULL;
+        m_items.clear();
+        m_cells.clear();
+        m_large.clear();
+        m_stamps.clear();
+    }
+
+    //! 开始框选，记下图形范围并建立网格
+    void begin(MgShapes* shapes)
+    {
+        Box2d extent;
+
+        end();
+        m_shapes = shapes;
+        m_changeCount = shapes->getChangeCount();
+        m_hasBox = false;
+
+        UInt32 n = shapes->findShapeExtents(Box2d(), 0, NULL, NULL);
+        std::vector<UInt32> ids(n);
+        std::vector<Box2d> extents(n);
+
+        if (n > 0)
+            n = mgMin(n, shapes->findShapeExtents(Box2d(), n, &ids.front(), &extents.front()));
+        for (UInt32 i = 0; i < n; i++) {
+            Item item = { NULL, ids[i], extents[i], false };
+            m_items.push_back(item);
+            extent.unionWith(item.extent);
+        }
+        m_stamps.resize(m_items.size(), 0);
+        m_stamp = 0;
+
+        int grid = 1;
+        while (grid < 256 && grid * grid * 4 < (int)m_items.size())
+            grid *= 2;
+        m_grid = grid;
+        m_origin = extent.leftBottom();
+        m_cellw = mgMax(extent.width() / grid, 1e-4f);
+        m_cellh = mgMax(extent.height() / grid, 1e-4f);
+        m_cells.resize(grid * grid);
+
+        for (UInt32 i = 0; i < m_items.size(); i++) {
+            int x1, y1, x2, y2;
+            getCells(m_items[i].extent, x1, y1, x2, y2);
+            if ((x2 - x1 + 1) * (y2 - y1 + 1) > 16) {
+                m_large.push_back(i);
+                continue;
+            }
+            for (int y = y1; y <= y2; y++) {
+                for (int x = x1; x <= x2; x++)
+                    m_cells[y * grid + x].push_back(i);
+            }
+        }
+    }
+
+    //! 按新的选择框更新选中状态，只检查可能改变的图形，返回选择是否改变
+    bool update(const Box2d& box, bool intersectMode)
+    {
+        if (m_shapes && m_shapes->getChangeCount() != m_changeCount)
+            begin(m_shapes);                    // 图形已改变则重新开始
+        if (!m_shapes)
+            return false;
+
+        bool changed = false;
+        bool modeChanged = (intersectMode != m_intersect);
+        Box2d query(box);
+        Box2d both;                             // 新旧选择框的交集
+
+        if (m_hasBox) {
+            query.unionWith(m_box);
+            if (!modeChanged && box.isIntersect(m_box))
+                both = box & m_box;
+        }
+        if (++m_stamp == 0) {
+            m_stamps.assign(m_stamps.size(), 0);
+            m_stamp = 1;
+        }
+
+        int x1, y1, x2, y2;
+        getCells(query, x1, y1, x2, y2);
+        for (int y = y1; y <= y2; y++) {
+            for (int x = x1; x <= x2; x++) {
+                const std::vector<UInt32>& cell = m_cells[y * m_grid + x];
+                for (UInt32 j = 0; j < cell.size(); j++)
+                    changed = test(cell[j], box, query, both, intersectMode) || changed;
+            }
+        }
+        for (UInt32 j = 0; j < m_large.size(); j++)
+            changed = test(m_large[j], box, query, both, intersectMode) || changed;
+
+        m_box = box;
+        m_hasBox = true;
+        m_intersect = intersectMode;
+
+        return changed;
+    }
+
+    //! 按图形顺序得到选中图形的ID和图形对象，要图形对象时载入选中的延迟载入图形
+    void getSelection(std::vector<UInt32>& ids, std::vector<MgShape*>* shapes = NULL)
+    {
+        ids.clear();
+        if (shapes)
+            shapes->clear();
+        for (UInt32 i = 0; i < m_items.size(); i++) {
+            if (!m_items[i].selected)
+                continue;
+            if (!shapes) {
+                ids.push_back(m_items[i].id);
+            }
+            else if (getShape(m_items[i])) {
+                ids.push_back(m_items[i].id);
+                shapes->push_back(m_items[i].shape);
+            }
+        }
+    }
+
+private:
+    struct Item {
+        MgShape*    shape;                      // 用到时才查找和载入
+        UInt32      id;
+        Box2d       extent;
+        bool        selected;
+    };
+
+    void getCells(const Box2d& rect, int& x1, int& y1, int& x2, int& y2) const
+    {
+        x1 = cellIndex((rect.xmin - m_origin.x) / m_cellw);
+        x2 = cellIndex((rect.xmax - m_origin.x) / m_cellw);
+        y1 = cellIndex((rect.ymin - m_origin.y) / m_cellh);
+        y2 = cellIndex((rect.ymax - m_origin.y) / m_cellh);
+    }
+
+    MgShape* getShape(Item& item)
+    {
+        if (!item.shape)
+            item.shape = m_shapes->findShape(item.id);
+        return item.shape;
+    }
+
+    int cellIndex(float f) const
+    {
+        return f < 0 ? 0 : (f >= m_grid ? m_grid - 1 : (int)f);
+    }
+
+    bool test(UInt32 i, const Box2d& box, const Box2d& query, const Box2d& both,
+              bool intersectMode)
+    {
+        Item& item = m_items[i];
+
+        if (m_stamps[i] == m_stamp)             // 已在其他网格中检查过
+            return false;
+        m_stamps[i] = m_stamp;
+
+        if (!item.extent.isIntersect(query))    // 新旧选择框外的图形都不会选中
+            return false;
+        if (!both.isNull() && both.contains(item.extent))
+            return false;                       // 在新旧选择框内的图形选中状态不变
+
+        bool sel = (intersectMode ? (getShape(item) && item.shape->shapec()->hitTestBox(box))
+                    : box.contains(item.extent));
+        if (sel != item.selected) {
+            item.selected = sel;
+            return true;
+        }
+        return false;
+    }
+
+private:
+    MgShapes*               m_shapes;       // 图形列表
+    UInt32                  m_changeCount;  // 开始框选时图形列表的改变次数
+    std::vector<Item>       m_items;        // 按图形顺序的图形范围和选中状态
+    std::vector<std::vector<UInt32> > m_cells;  // 网格中各单元包含的图形序号
+    std::vector<UInt32>     m_large;        // 占用很多网格的大图形序号
+    std::vector<UInt32>     m_stamps;       // 图形最近一次检查的标记
+    UInt32                  m_stamp;        // 本次检查的标记
+    int                     m_grid;         // 网格行列数
+    Point2d                 m_origin;       // 网格左下角
+    float                   m_cellw;        // 网格单元宽
+    float                   m_cellh;        // 网格单元高
+    Box2d                   m_box;          // 上次选择框
+    bool                    m_hasBox;       // 是否有上次选择框
+    bool                    m_intersect;    // 上次是否为相交选择模式
+};
+
+#endif // __GEOMETRY_MGBOXSELECTOR_H_
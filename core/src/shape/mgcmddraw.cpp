@@ -4,10 +4,13 @@
 
 #include "mgcmddraw.h"
 #include <mgsnap.h>
+#include <mgbasicsp.h>
+#include <gicanvas.h>
 
 UInt32      g_newShapeID = 0;
 
-MgCommandDraw::MgCommandDraw() : m_step(0), m_shape(NULL), m_needClear(false)
+MgCommandDraw::MgCommandDraw() : m_step(0), m_shape(NULL), m_needClear(false), m_cachedCount(0)
+    , m_cachedCanvas(NULL), m_cachedChanges(0)
 {
 }
 
@@ -23,6 +26,7 @@ bool MgCommandDraw::cancel(const MgMotion* sender)
 {
     if (m_step > 0) {
         m_step = 0;
+        m_cachedCount = 0;
         m_shape->shape()->clear();
         sender->view->redraw(false);
         return true;
@@ -42,6 +46,7 @@ bool MgCommandDraw::_initialize(MgShape* (*creator)(), const MgMotion* sender)
     g_newShapeID = 0;
     m_step = 0;
     m_needClear = false;
+    m_cachedCount = 0;
     m_shape->shape()->clear();
     if (sender->view->context()) {
         *m_shape->context() = *sender->view->context();
@@ -83,15 +88,64 @@ bool MgCommandDraw::draw(const MgMotion* sender, GiGraphics* gs)
     if (m_needClear) {
         m_needClear = false;
         m_step = 0;
+        m_cachedCount = 0;
         m_shape->shape()->clear();
     }
-    bool ret = m_step > 0 && m_shape->draw(*gs);
+    
+    UInt32 fixed = m_step > 0 ? getFixedCount() : 0;
+    bool ret = (fixed > 1 ? drawIncremental(sender, gs, fixed)
+                : m_step > 0 && m_shape->draw(*gs));
     if (m_step > 0 && sender->dragging) {
         sender->view->drawHandle(gs, sender->pointM, true);
     }
     return mgGetCommandManager()->getSnap()->draw(sender, gs) || ret;
 }
 
+bool MgCommandDraw::drawIncremental(const MgMotion* sender, GiGraphics* gs, UInt32 fixed)
+{
+    GiCanvas* cv = gs->getCanvas();
+    
+    if (!cv || !cv->isBufferedDrawing() || !m_shape->shapec()->isKindOf(MgBaseLines::Type())) {
+        m_cachedCount = 0;
+        return m_shape->draw(*gs);
+    }
+    
+    const MgBaseLines* lines = (const MgBaseLines*)m_shape->shapec();
+    UInt32 n = lines->getPointCount();
+    
+    if (lines->isClosed() || fixed > n) {
+        m_cachedCount = 0;
+        return m_shape->draw(*gs);
+    }
+    
+    const GiContext& ctx = *m_shape->contextc();
+    UInt32 changes = sender->view->shapes()->getChangeCount();
+    UInt32 from = 0;
+    
+    // 同一画布、显示变换和图形列表下已保存的部分未变化时只补画新增的固定段，否则完整重画固定部分
+    if (m_cachedCount > 1 && m_cachedCount <= fixed
+        && m_cachedCanvas == cv && m_cachedChanges == changes
+        && m_cachedXf == gs->xf().modelToDisplay()
+        && cv->hasCachedBitmap(true)
+        && lines->getPoint(m_cachedCount - 1) == m_cachedEnd
+        && cv->drawCachedBitmap(0, 0, true)) {
+        from = m_cachedCount - 1;
+    }
+    if (from + 1 < fixed || from == 0) {
+        lines->drawPart(*gs, ctx, from, fixed - 1);
+        cv->saveCachedBitmap(true);
+        m_cachedCount = fixed;
+        m_cachedEnd = lines->getPoint(fixed - 1);
+        m_cachedCanvas = cv;
+        m_cachedXf = gs->xf().modelToDisplay();
+        m_cachedChanges = changes;
+    }
+    
+    lines->drawPart(*gs, ctx, fixed - 1, n - 1);
+    
+    return true;
+}
+
 void MgCommandDraw::gatherShapes(const MgMotion* /*sender*/, MgShapes* shapes)
 {
     if (m_step > 0 && m_shape) {
@@ -116,6 +170,7 @@ bool MgCommandDraw::longPress(const MgMotion* /*sender*/)
 
 bool MgCommandDraw::_touchBegan(const MgMotion* sender)
 {
+    m_cachedCount = 0;
     if (sender->view->context()) {
         *m_shape->context() = *sender->view->context();
     }
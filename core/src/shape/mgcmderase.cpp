@@ -10,7 +10,7 @@
 
 float mgDisplayMmToModel(float mm, const MgMotion* sender);
 
-MgCommandErase::MgCommandErase()
+MgCommandErase::MgCommandErase() : m_changeCount(0)
 {
 }
 
@@ -38,6 +38,8 @@ bool MgCommandErase::undo(bool &enableRecall, const MgMotion* sender)
     enableRecall = true;
     if (!m_delIds.empty()) {
         m_delIds.pop_back();
+        if (!m_delShapes.empty())
+            m_delShapes.pop_back();
         sender->view->redraw(false);
         return true;
     }
@@ -61,10 +63,19 @@ bool MgCommandErase::draw(const MgMotion* sender, GiGraphics* gs)
     
     GiContext ctx(-4, GiColor(64, 64, 64, 128));
     
-    for (std::vector<UInt32>::const_iterator it = m_delIds.begin(); it != m_delIds.end(); ++it) {
-        MgShape* shape = sender->view->shapes()->findShape(*it);
-        if (shape)
-            shape->draw(*gs, &ctx);
+    if (m_delShapes.size() == m_delIds.size()
+        && m_changeCount == sender->view->shapes()->getChangeCount()) {
+        for (std::vector<MgShape*>::const_iterator it = m_delShapes.begin();
+             it != m_delShapes.end(); ++it) {
+            (*it)->draw(*gs, &ctx);
+        }
+    }
+    else {
+        for (std::vector<UInt32>::const_iterator it = m_delIds.begin(); it != m_delIds.end(); ++it) {
+            MgShape* shape = sender->view->shapes()->findShape(*it);
+            if (shape)
+                shape->draw(*gs, &ctx);
+        }
     }
     
     return true;
@@ -118,6 +129,7 @@ bool MgCommandErase::longPress(const MgMotion* /*sender*/)
 bool MgCommandErase::touchBegan(const MgMotion* sender)
 {
     m_boxsel = true;
+    m_boxQuery.end();
     sender->view->redraw(false);
     return true;
 }
@@ -131,17 +143,22 @@ bool MgCommandErase::isIntersectMode(const MgMotion* sender)
 bool MgCommandErase::touchMoved(const MgMotion* sender)
 {
     Box2d snap(sender->startPointM, sender->pointM);
-    void *it = NULL;
-    MgShape* shape = m_boxsel ? sender->view->shapes()->getFirstShape(it) : NULL;
     
-    m_delIds.clear();
-    for (; shape; shape = sender->view->shapes()->getNextShape(it)) {
-        if (isIntersectMode(sender) ? shape->shape()->hitTestBox(snap)
-            : snap.contains(shape->shape()->getExtent())) {
-            m_delIds.push_back(shape->getID());
+    if (!m_boxsel) {
+        m_delIds.clear();
+        m_delShapes.clear();
+    }
+    else {
+        if (!m_boxQuery.started()) {
+            m_boxQuery.begin(sender->view->shapes());
+            m_delIds.clear();
+            m_delShapes.clear();
+        }
+        if (m_boxQuery.update(snap, isIntersectMode(sender))) {
+            m_boxQuery.getSelection(m_delIds, &m_delShapes);
         }
+        m_changeCount = sender->view->shapes()->getChangeCount();
     }
-    sender->view->shapes()->freeIterator(it);
     sender->view->redraw(false);
     
     return true;
@@ -162,9 +179,11 @@ bool MgCommandErase::touchEnded(const MgMotion* sender)
         
         sender->view->regen();
         m_delIds.clear();
+        m_delShapes.clear();
     }
     
     m_boxsel = false;
+    m_boxQuery.end();
     sender->view->redraw(false);
     
     return true;
@@ -8,6 +8,7 @@
 
 #include <mgcmd.h>
 #include <vector>
+#include "mgboxsel.h"
 
 //! 橡皮擦命令类
 /*! \ingroup GEOM_SHAPE
@@ -44,6 +45,9 @@ private:
     bool isIntersectMode(const MgMotion* sender);
     
     std::vector<UInt32>     m_delIds;
+    std::vector<MgShape*>   m_delShapes;    // 与 m_delIds 对应的图形，图形列表未改变时有效
+    UInt32                  m_changeCount;  // 得到 m_delShapes 时图形列表的改变次数
+    MgBoxSelector           m_boxQuery;     // 框选时增量检查图形
     bool                    m_boxsel;
 };
 
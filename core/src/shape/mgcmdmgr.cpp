@@ -5,23 +5,22 @@
 #include "mgcmdmgr.h"
 #include "mgcmdselect.h"
 #include <mggrid.h>
+#include <mgshapet.h>
+#include "mgfactory.h"
 
 MgCommand* mgCreateCoreCommand(const char* name);
 float mgDisplayMmToModel(float mm, GiGraphics* gs);
 float mgDisplayMmToModel(float mm, const MgMotion* sender);
 
-typedef std::map<std::string, MgCommand* (*)()> Factories;
+typedef MgFactoryTable<MgCommand* (*)(), 128> Factories;
 static Factories    _factories;
 static MgCmdManagerImpl* s_manager = NULL;
 static MgCmdManagerImpl s_tmpmgr(true);
 
 void mgRegisterCommand(const char* name, MgCommand* (*factory)())
 {
-    if (!factory) {
-        _factories.erase(name);
-    }
-    else {
-        _factories[name] = factory;
+    if (name && *name) {
+        _factories.set(Factories::hashName(name), name, factory);
     }
 }
 
@@ -32,6 +31,9 @@ MgCommandManager* mgGetCommandManager()
 
 MgCmdManagerImpl::MgCmdManagerImpl(bool tmpobj)
 {
+    _gridSnap.shapes = NULL;
+    _gridSnap.changeCount = 0;
+    _gridSnap.valid = false;
     if (!s_manager && !tmpobj)
         s_manager = this;
 }
@@ -69,12 +71,9 @@ bool MgCmdManagerImpl::setCommand(const MgMotion* sender, const char* name)
     CMDS::iterator it = _cmds.find(name);
     if (it == _cmds.end())
     {
-        MgCommand* cmd = NULL;
-        Factories::iterator itf = _factories.find(name);
+        MgCommand* (*factory)() = _factories.find(Factories::hashName(name), name);
+        MgCommand* cmd = factory ? factory() : NULL;
         
-        if (itf != _factories.end()) {
-            cmd = itf->second ? (itf->second)() : NULL;
-        }
         if (!cmd) {
             cmd = mgCreateCoreCommand(name);
         }
@@ -170,11 +169,21 @@ static void snapPoints(const MgMotion* sender, MgShape* shape, SnapItem arr[3],
     Box2d snapbox(sender->pointM, 2 * arr[0].dist, 0);
     GiTransform* xf = sender->view->xform();
     Box2d wndbox(Box2d(0, 0, xf->getWidth(), xf->getHeight()) * xf->displayToModel());
-    void* it = NULL;
+    MgShapes* shapes = sender->view->shapes();
+    Box2d query(wndbox);
     
-    for (MgShape* sp = sender->view->shapes()->getFirstShape(it);
-         sp; sp = sender->view->shapes()->getNextShape(it)) {
-        if (shape && shape->getID() == sp->getID())
+    if (!matchpt) {                     // 先按图形索引中的范围剔除，只载入可能捕捉到的图形
+        query.set(mgMin(query.xmin, snapbox.xmin), mgMin(query.ymin, snapbox.ymin),
+                  mgMax(query.xmax, snapbox.xmax), mgMax(query.ymax, snapbox.ymax));
+    }
+    std::vector<UInt32> ids(shapes->findShapeExtents(query, 0, NULL, NULL));
+    if (!ids.empty())
+        ids.resize(mgMin((UInt32)ids.size(),
+                         shapes->findShapeExtents(query, (UInt32)ids.size(), &ids.front(), NULL)));
+    
+    for (size_t k = 0; k < ids.size(); k++) {
+        MgShape* sp = shapes->findShape(ids[k]);
+        if (!sp || (shape && shape->getID() == sp->getID()))
             continue;
         bool allOnBox = !matchpt && sp->shape()->getExtent().isIntersect(snapbox);
         if (allOnBox || sp->shape()->getExtent().isIntersect(wndbox)) {
@@ -209,25 +218,56 @@ static void snapPoints(const MgMotion* sender, MgShape* shape, SnapItem arr[3],
                     }
                 }
             }
-            
-            if (allOnBox && sp->shape()->isKindOf(MgGrid::Type())) {
-                Point2d newPt (sender->pointM);
-                MgGrid* grid = (MgGrid*)(sp->shape());
-                int type = grid->snap(newPt, arr[1].dist, arr[2].dist);
-                if (type & 1) {
-                    arr[1].base = newPt;
-                    arr[1].pt = newPt;
-                    arr[1].type = 3;
-                }
-                if (type & 2) {
-                    arr[2].base = newPt;
-                    arr[2].pt = newPt;
-                    arr[2].type = 4;
-                }
-            }
         }
     }
-    sender->view->shapes()->freeIterator(it);
+}
+
+// 网格在图形列表改变时才按图形索引重新查找，不载入其他图形，同一位置和显示比例下直接使用上次的捕捉结果
+void MgCmdManagerImpl::snapGrids(const MgMotion* sender, MgShape* hotShape, float tol)
+{
+    GridSnap& c = _gridSnap;
+    MgShapes* shapes = sender->view->shapes();
+    UInt32 skipID = hotShape ? hotShape->getID() : 0;
+    
+    if (c.shapes != shapes || c.changeCount != shapes->getChangeCount()) {
+        const UInt32 type = MgShapeT<MgGrid>::Type();
+        
+        c.shapes = shapes;
+        c.changeCount = shapes->getChangeCount();
+        c.grids.resize(shapes->findShapesByType(type, 0, NULL));
+        if (!c.grids.empty()) {
+            UInt32 n = shapes->findShapesByType(type, (UInt32)c.grids.size(), &c.grids.front());
+            if (n < c.grids.size())
+                c.grids.resize(n);
+        }
+        c.valid = false;
+    }
+    if (c.valid && c.pointM == sender->pointM && c.tol == tol && c.skipID == skipID)
+        return;
+    
+    Box2d snapbox(sender->pointM, 2 * mgDisplayMmToModel(5.f, sender), 0);
+    
+    c.valid = true;
+    c.pointM = sender->pointM;
+    c.tol = tol;
+    c.skipID = skipID;
+    c.type = 0;
+    c.distx = tol;
+    c.disty = tol;
+    
+    for (size_t i = 0; i < c.grids.size(); i++) {
+        MgShape* sp = c.grids[i];
+        if (sp->getID() == skipID || !sp->shape()->getExtent().isIntersect(snapbox))
+            continue;
+        
+        Point2d newPt (sender->pointM);
+        int type = ((MgGrid*)sp->shape())->snap(newPt, c.distx, c.disty);
+        if (type & 1)
+            c.ptx = newPt;
+        if (type & 2)
+            c.pty = newPt;
+        c.type |= type;
+    }
 }
 
 Point2d MgCmdManagerImpl::snapPoint(const MgMotion* sender, MgShape* shape, int hotHandle)
@@ -253,6 +293,20 @@ Point2d MgCmdManagerImpl::snapPoint(const MgMotion* sender, MgShape* shape, int
     
     snapPoints(sender, shape, arr, matchpt ? &pnt : NULL);
     
+    if (!matchpt) {
+        snapGrids(sender, shape, mgDisplayMmToModel(3.f, sender));
+        if ((_gridSnap.type & 1) && _gridSnap.distx < 3 * arr[1].dist) {
+            arr[1].base = arr[1].pt = _gridSnap.ptx;
+            arr[1].dist = _gridSnap.distx;
+            arr[1].type = 3;
+        }
+        if ((_gridSnap.type & 2) && _gridSnap.disty < 3 * arr[2].dist) {
+            arr[2].base = arr[2].pt = _gridSnap.pty;
+            arr[2].dist = _gridSnap.disty;
+            arr[2].type = 4;
+        }
+    }
+    
     if (arr[0].type >= 0) {
         _ptSnap = arr[0].pt;
         _snapType[0] = arr[0].type;
@@ -10,6 +10,7 @@
 #include <mgsnap.h>
 #include <map>
 #include <string>
+#include <vector>
 
 //! 命令管理器实现类
 /*! \ingroup GEOM_SHAPE
@@ -35,6 +36,8 @@ private:
     virtual bool draw(const MgMotion* sender, GiGraphics* gs);
     virtual Point2d snapPoint(const MgMotion* sender, MgShape* hotShape, int hotHandle);
     virtual int getSnappedType();
+    
+    void snapGrids(const MgMotion* sender, MgShape* hotShape, float tol);
 
 private:
     typedef std::map<std::string, MgCommand*> CMDS;
@@ -44,6 +47,19 @@ private:
     Point2d         _ptSnap;
     Point2d         _snapBase[2];
     int             _snapType[2];
+    
+    struct GridSnap {                       //!< 网格捕捉缓存
+        MgShapes*       shapes;             //!< 网格所在的图形列表
+        UInt32          changeCount;        //!< 查找网格时图形列表的改变次数
+        std::vector<MgShape*> grids;        //!< 图形列表中的网格
+        bool            valid;              //!< 下列捕捉结果是否有效
+        Point2d         pointM;             //!< 捕捉位置
+        float           tol;                //!< 捕捉容差，随显示比例变化
+        UInt32          skipID;             //!< 不参与捕捉的图形的ID
+        int             type;               //!< 捕捉结果，1:X方向，2:Y方向
+        Point2d         ptx, pty;           //!< X、Y方向捕捉到的点
+        float           distx, disty;       //!< X、Y方向的捕捉距离
+    } _gridSnap;
 };
 
 #endif // __GEOMETRY_MGCOMMAND_MANAGER_H_
@@ -2,8 +2,6 @@
 // Copyright (c) 2004-2012, Zhang Yungui
 // License: LGPL, https://github.com/rhcad/touchvg
 
-#include <string.h>
-#include <map>
 #include "mgcmdselect.h"
 #include "mgcmderase.h"
 #include "mgdrawrect.h"
@@ -14,9 +12,20 @@
 #include <mgbasicsp.h>
 #include <mgshapet.h>
 #include "mggrid.h"
+#include "mgfactory.h"
 
-MgCommand* mgCreateCoreCommand(const char* name)
+typedef MgFactoryTable<MgCommand* (*)(), 64> CommandTable;
+static CommandTable     s_coreCommands;
+static volatile long    s_coreCommandsInited = 0;
+static GiMutex          s_initMutex;
+
+static void registerCoreCommands()
 {
+    GiMutexLock locker(s_initMutex);
+    
+    if (s_coreCommandsInited)
+        return;
+    
     typedef MgCommand* (*FCreate)();
     struct Cmd {
         const char* name;
@@ -44,11 +53,22 @@ MgCommand* mgCreateCoreCommand(const char* name)
     
     for (unsigned i = 0; i < sizeof(cmds)/sizeof(cmds[0]); i++)
     {
-        if (strcmp(cmds[i].name, name) == 0)
-            return (cmds[i].creator)();
+        s_coreCommands.set(CommandTable::hashName(cmds[i].name), cmds[i].name, cmds[i].creator);
+    }
+    giInterlockedExchange(&s_coreCommandsInited, 1);
+}
+
+MgCommand* mgCreateCoreCommand(const char* name)
+{
+    const UInt32 hash = CommandTable::hashName(name);
+    MgCommand* (*creator)() = s_coreCommands.find(hash, name);
+    
+    if (!creator && !giAtomicLoad(&s_coreCommandsInited)) {
+        registerCoreCommands();
+        creator = s_coreCommands.find(hash, name);
     }
     
-    return NULL;
+    return creator ? creator() : NULL;
 }
 
 typedef std::pair<MgShapesLock::ShapesLocked, void*> ShapeObserver;
@@ -70,29 +90,56 @@ MgLockRW::MgLockRW() : _editFlags(0)
     _counts[0] = _counts[1] = _counts[2] = 0;
 }
 
+// 先忙等和让出时间片，短时间得不到锁时再按25毫秒休眠，累计到超时为止
+static bool waitLock(int& waited, int& spins, int timeout)
+{
+    if (spins < 32) {
+        giBackoff(spins++);
+        return true;
+    }
+    if (waited >= timeout)
+        return false;
+    giSleep(25);
+    waited += 25;
+    return true;
+}
+
 bool MgLockRW::lock(bool forWrite, int timeout)
 {
-    bool ret = false;
+    int waited = 0, spins = 0;
     
-    if (1 == giInterlockedIncrement(_counts)) {     // first locked
-        giInterlockedIncrement(_counts + (forWrite ? 2 : 1));
-        ret = true;
-    }
-    else {
-        ret = !forWrite && 0 == _counts[2];         // for read and not locked for write
-        for (int i = 0; i < timeout && !ret; i += 25) {
-            giSleep(25);
-            ret = forWrite ? (!_counts[1] && !_counts[2]) : !_counts[2];
+    giInterlockedIncrement(_counts);
+    if (forWrite) {
+        // 先占住写标记，新的读方不再进入，再等已有的读方结束
+        while (giInterlockedCompareExchange(_counts + 2, 1, 0) != 0) {
+            if (!waitLock(waited, spins, timeout)) {
+                giInterlockedDecrement(_counts);
+                return false;
+            }
         }
-        if (ret) {
-            giInterlockedIncrement(_counts + (forWrite ? 2 : 1));
+        while (giAtomicLoad(_counts + 1) != 0) {
+            if (!waitLock(waited, spins, timeout)) {
+                giInterlockedDecrement(_counts + 2);
+                giInterlockedDecrement(_counts);
+                return false;
+            }
         }
-        else {
-            giInterlockedDecrement(_counts);
+    }
+    else {
+        // 先登记读方再检查写标记，与写方的顺序相反，两者不会同时进入
+        for (;;) {
+            giInterlockedIncrement(_counts + 1);
+            if (giAtomicLoad(_counts + 2) == 0)
+                break;
+            giInterlockedDecrement(_counts + 1);
+            if (!waitLock(waited, spins, timeout)) {
+                giInterlockedDecrement(_counts);
+                return false;
+            }
         }
     }
     
-    return ret;
+    return true;
 }
 
 long MgLockRW::unlock(bool forWrite)
@@ -103,17 +150,17 @@ long MgLockRW::unlock(bool forWrite)
 
 bool MgLockRW::firstLocked()
 {
-    return _counts[0] == 1;
+    return giAtomicLoad(_counts) == 1;
 }
 
 bool MgLockRW::lockedForRead()
 {
-    return _counts[0] > 0;
+    return giAtomicLoad(_counts) > 0;
 }
 
 bool MgLockRW::lockedForWrite()
 {
-    return _counts[2] > 0;
+    return giAtomicLoad(_counts + 2) > 0;
 }
 
 // MgShapesLock
@@ -132,6 +179,8 @@ MgShapesLock::MgShapesLock(MgShapes* sp, int flags, int timeout) : shapes(sp)
             (it->first)(shapes, it->second, true);
         }
     }
+    if (m_mode == 2 && (flags == Add || flags == Modify))
+        m_mode |= 8;                // 写锁不可重入，增删改都已通知图形列表
 }
 
 MgShapesLock::~MgShapesLock()
@@ -141,8 +190,11 @@ MgShapesLock::~MgShapesLock()
     if (locked() && shapes) {
         ended = (0 == shapes->getLockData()->unlock((m_mode & 2) != 0));
     }
-    if (m_mode == 2 && ended) {
-        shapes->afterChanged();
+    if ((m_mode & ~8) == 2 && ended) {
+        if (m_mode & 8)
+            shapes->afterShapeChanged(NULL);
+        else
+            shapes->afterChanged();
         for (std::vector<ShapeObserver>::iterator it = s_shapeObservers.begin();
              it != s_shapeObservers.end(); ++it) {
             (it->first)(shapes, it->second, false);
@@ -217,42 +269,50 @@ bool MgDynShapeLock::lockedForWrite()
 // mgRegisterShapeCreator, mgCreateShape
 //
 
-static std::map<UInt32, MgShape* (*)()>   s_shapeCreators;
+// 核心图形类型号都小于槽数，以类型号为键，通常一次探测即可找到
+typedef MgFactoryTable<MgShape* (*)(), 256> ShapeTable;
+static ShapeTable       s_shapeCreators;
+static volatile long    s_coreShapesInited = 0;
 
 static void registerCoreCreators()
 {
-    s_shapeCreators[MgShapeT<MgLine>::Type() % 10000] = MgShapeT<MgLine>::create;
-    s_shapeCreators[MgShapeT<MgRect>::Type() % 10000] = MgShapeT<MgRect>::create;
-    s_shapeCreators[MgShapeT<MgEllipse>::Type() % 10000] = MgShapeT<MgEllipse>::create;
-    s_shapeCreators[MgShapeT<MgRoundRect>::Type() % 10000] = MgShapeT<MgRoundRect>::create;
-    s_shapeCreators[MgShapeT<MgDiamond>::Type() % 10000] = MgShapeT<MgDiamond>::create;
-    s_shapeCreators[MgShapeT<MgParallelogram>::Type() % 10000] = MgShapeT<MgParallelogram>::create;
-    s_shapeCreators[MgShapeT<MgLines>::Type() % 10000] = MgShapeT<MgLines>::create;
-    s_shapeCreators[MgShapeT<MgSplines>::Type() % 10000] = MgShapeT<MgSplines>::create;
-    s_shapeCreators[MgShapeT<MgGrid>::Type() % 10000] = MgShapeT<MgGrid>::create;
+    GiMutexLock locker(s_initMutex);
+    
+    if (s_coreShapesInited)
+        return;
+    
+    s_shapeCreators.set(MgShapeT<MgLine>::Type() % 10000, NULL, MgShapeT<MgLine>::create);
+    s_shapeCreators.set(MgShapeT<MgRect>::Type() % 10000, NULL, MgShapeT<MgRect>::create);
+    s_shapeCreators.set(MgShapeT<MgEllipse>::Type() % 10000, NULL, MgShapeT<MgEllipse>::create);
+    s_shapeCreators.set(MgShapeT<MgRoundRect>::Type() % 10000, NULL, MgShapeT<MgRoundRect>::create);
+    s_shapeCreators.set(MgShapeT<MgDiamond>::Type() % 10000, NULL, MgShapeT<MgDiamond>::create);
+    s_shapeCreators.set(MgShapeT<MgParallelogram>::Type() % 10000, NULL, MgShapeT<MgParallelogram>::create);
+    s_shapeCreators.set(MgShapeT<MgLines>::Type() % 10000, NULL, MgShapeT<MgLines>::create);
+    s_shapeCreators.set(MgShapeT<MgSplines>::Type() % 10000, NULL, MgShapeT<MgSplines>::create);
+    s_shapeCreators.set(MgShapeT<MgGrid>::Type() % 10000, NULL, MgShapeT<MgGrid>::create);
+    giInterlockedExchange(&s_coreShapesInited, 1);
 }
 
 void mgRegisterShapeCreator(UInt32 type, MgShape* (*factory)())
 {
-    if (s_shapeCreators.empty()) {
-        registerCoreCreators();
-    }
     type = type % 10000;
     if (type > 20) {
-        if (factory) {
-            s_shapeCreators[type] = factory;
-        }
-        else {
-            s_shapeCreators.erase(type);
-        }
+        s_shapeCreators.set(type, NULL, factory);
     }
 }
 
 MgShape* mgCreateShape(UInt32 type)
 {
-    if (s_shapeCreators.empty())
+    type = type % 10000;
+    if (0 == type)
+        return NULL;
+    
+    MgShape* (*creator)() = s_shapeCreators.find(type);
+    
+    if (!creator && !giAtomicLoad(&s_coreShapesInited)) {
         registerCoreCreators();
+        creator = s_shapeCreators.find(type);
+    }
     
-    std::map<UInt32, MgShape* (*)()>::const_iterator it = s_shapeCreators.find(type % 10000);
-    return (it != s_shapeCreators.end()) ? (it->second)() : NULL;
+    return creator ? creator() : NULL;
 }
@@ -466,6 +466,7 @@ bool MgCommandSelect::touchBegan(const MgMotion* sender)
     
     if (m_clones.empty())
         m_boxsel = true;
+    m_boxQuery.end();
     m_boxHandle = 99;
     
     sender->view->redraw(m_clones.size() < 2);
@@ -619,19 +620,16 @@ bool MgCommandSelect::touchMoved(const MgMotion* sender)
     
     if (m_clones.empty() && m_boxsel) {    // 没有选中图形时就滑动多选
         Box2d snap(sender->startPointM, sender->pointM);
-        void *it = NULL;
-        MgShape* shape = sender->view->shapes()->getFirstShape(it);
         
-        m_selIds.clear();
-        m_id = 0;
-        for (; shape; shape = sender->view->shapes()->getNextShape(it)) {
-            if (isIntersectMode(sender) ? shape->shape()->hitTestBox(snap)
-                : snap.contains(shape->shape()->getExtent())) {
-                m_selIds.push_back(shape->getID());
-                m_id = shape->getID();
-            }
+        if (!m_boxQuery.started()) {
+            m_boxQuery.begin(sender->view->shapes());
+            m_selIds.clear();
+            m_id = 0;
+        }
+        if (m_boxQuery.update(snap, isIntersectMode(sender))) {
+            m_boxQuery.getSelection(m_selIds);
+            m_id = m_selIds.empty() ? 0 : m_selIds.back();
         }
-        sender->view->shapes()->freeIterator(it);
         sender->view->redraw(true);
     }
     
@@ -666,6 +664,7 @@ bool MgCommandSelect::touchEnded(const MgMotion* sender)
     }
     if (m_boxsel) {
         m_boxsel = false;
+        m_boxQuery.end();
         if (m_selIds.size() > 1)
             m_handleMode = false;
         if (!m_selIds.empty())
@@ -700,7 +699,7 @@ bool MgCommandSelect::applyCloneShapes(MgView* view, bool apply, bool addNewShap
     
     if (!m_clones.empty()) {
         MgShapesLock locker(view->shapes(), !apply ? MgShapesLock::ReadOnly
-                            : (addNewShapes ? MgShapesLock::Add : MgShapesLock::Edit));
+                            : (addNewShapes ? MgShapesLock::Add : MgShapesLock::Modify));
         
         if (apply && addNewShapes) {
             m_selIds.clear();
@@ -722,6 +721,7 @@ bool MgCommandSelect::applyCloneShapes(MgView* view, bool apply, bool addNewShap
                 if (shape) {
                     shape->copy(*m_clones[i]);
                     shape->shape()->update();
+                    view->shapes()->afterShapeChanged(shape);
                     changed = true;
                 }
             }
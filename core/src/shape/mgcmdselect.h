@@ -9,6 +9,7 @@
 #include <mgcmd.h>
 #include <mgselect.h>
 #include <vector>
+#include "mgboxsel.h"
 
 //! 选择命令类
 /*! \ingroup GEOM_SHAPE
@@ -93,6 +94,7 @@ private:
     bool                    m_insertPt;         // 是否可插入新点
     bool                    m_showSel;          // 是否亮显选中的图形
     bool                    m_boxsel;           // 是否开始框选
+    MgBoxSelector           m_boxQuery;         // 框选时增量检查图形
 };
 
 #endif // __GEOMETRY_MGCOMMAND_SELECT_H_
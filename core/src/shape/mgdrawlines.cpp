@@ -66,6 +66,18 @@ bool MgCmdDrawLines::touchMoved(const MgMotion* sender)
     return _touchMoved(sender);
 }
 
+bool MgCmdDrawLines::touchMovedPoints(const MgMotion* sender, UInt32 count, const Point2d* points)
+{
+    if (count == 0)
+        return touchMoved(sender);
+    
+    MgMotion motion(*sender);               // 只有最后的采样点影响动态边，不用预测点捕捉
+    motion.pointM = points[count - 1];
+    motion.point = motion.pointM * sender->view->xform()->modelToDisplay();
+    
+    return touchMoved(&motion);
+}
+
 bool MgCmdDrawLines::touchEnded(const MgMotion* sender)
 {
     Point2d pnt(snapPoint(sender));
@@ -220,6 +232,33 @@ bool MgCmdDrawFreeLines::touchMoved(const MgMotion* sender)
     return _touchMoved(sender);
 }
 
+bool MgCmdDrawFreeLines::touchMovedPoints(const MgMotion* sender, UInt32 count, const Point2d* points)
+{
+    if (count < 2)
+        return touchMoved(sender);
+    
+    for (UInt32 i = 0; i + 1 < count && !dynshape()->shape()->isClosed(); i++) {
+        dynshape()->shape()->setPoint(m_step, points[i]);
+        if (m_step > 0 && canAddPoint(sender, false)) {
+            m_step++;
+            if (m_step >= dynshape()->shape()->getPointCount()) {
+                ((MgBaseLines*)dynshape()->shape())->addPoint(points[i]);
+            }
+        }
+    }
+    
+    MgMotion motion(*sender);               // 最后一个采样点按原方式判断闭合
+    motion.pointM = points[count - 1];
+    bool ret = touchMoved(&motion);
+    
+    if (!dynshape()->shape()->isClosed() && motion.pointM != sender->pointM) {
+        dynshape()->shape()->setPoint(m_step, sender->pointM);  // 预测点只作为动态点
+        dynshape()->shape()->update();
+    }
+    
+    return ret;
+}
+
 bool MgCmdDrawFreeLines::touchEnded(const MgMotion* sender)
 {
     MgBaseLines* lines = (MgBaseLines*)dynshape()->shape();
@@ -255,6 +294,12 @@ bool MgCmdDrawFreeLines::touchEnded(const MgMotion* sender)
     return _touchEnded(sender);
 }
 
+UInt32 MgCmdDrawFreeLines::getFixedCount()
+{
+    // 当前点之前的顶点不再变化，闭合时首尾相连则完整显示
+    return dynshape()->shapec()->isClosed() ? 0 : m_step;
+}
+
 bool MgCmdDrawFreeLines::canAddPoint(const MgMotion* /*sender*/, bool /*ended*/)
 {
     /*float minDist = mgDisplayMmToModel(3, sender);
@@ -31,7 +31,9 @@ private:
     virtual bool draw(const MgMotion* sender, GiGraphics* gs);
     virtual bool touchBegan(const MgMotion* sender);
     virtual bool touchMoved(const MgMotion* sender);
+    virtual bool touchMovedPoints(const MgMotion* sender, UInt32 count, const Point2d* points);
     virtual bool touchEnded(const MgMotion* sender);
+    virtual UInt32 getFixedCount();
     
 private:
     bool canAddPoint(const MgMotion* sender, bool ended);
@@ -62,6 +64,7 @@ private:
     virtual bool undo(bool &enableRecall, const MgMotion* sender);
     virtual bool touchBegan(const MgMotion* sender);
     virtual bool touchMoved(const MgMotion* sender);
+    virtual bool touchMovedPoints(const MgMotion* sender, UInt32 count, const Point2d* points);
     virtual bool touchEnded(const MgMotion* sender);
     virtual bool click(const MgMotion* sender);
     virtual bool doubleClick(const MgMotion* sender);
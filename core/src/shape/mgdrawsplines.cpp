@@ -71,16 +71,24 @@ bool MgCmdDrawSplines::touchBegan(const MgMotion* sender)
 }
 
 bool MgCmdDrawSplines::touchMoved(const MgMotion* sender)
+{
+    return touchMovedPoints(sender, 1, &sender->pointM);
+}
+
+bool MgCmdDrawSplines::touchMovedPoints(const MgMotion* sender, UInt32 count, const Point2d* points)
 {
     MgBaseLines* lines = (MgBaseLines*)dynshape()->shape();
     
-    dynshape()->shape()->setPoint(m_step, sender->pointM);
-    if (m_step > 0 && canAddPoint(sender, false)) {
-        m_step++;
-        if (m_step >= dynshape()->shape()->getPointCount()) {
-            lines->addPoint(sender->pointM);
+    for (UInt32 i = 0; i < count; i++) {
+        dynshape()->shape()->setPoint(m_step, points[i]);
+        if (m_step > 0 && canAddPoint(sender, points[i], false)) {
+            m_step++;
+            if (m_step >= dynshape()->shape()->getPointCount()) {
+                lines->addPoint(points[i]);
+            }
         }
     }
+    dynshape()->shape()->setPoint(m_step, sender->pointM);  // 可能是预测点
     dynshape()->shape()->update();
     
     return _touchMoved(sender);
@@ -123,13 +131,19 @@ bool MgCmdDrawSplines::cancel(const MgMotion* sender)
     return MgCommandDraw::cancel(sender);
 }
 
-bool MgCmdDrawSplines::canAddPoint(const MgMotion* sender, bool ended)
+UInt32 MgCmdDrawSplines::getFixedCount()
+{
+    // 末端两个顶点的切矢还会随新点变化，不作为固定部分
+    return m_freehand && m_step > 2 ? m_step - 2 : 0;
+}
+
+bool MgCmdDrawSplines::canAddPoint(const MgMotion* sender, const Point2d& pt, bool ended)
 {
     if (!m_freehand && !ended)
         return false;
     
     if (m_step > 0 && mgDisplayMmToModel(ended ? 0.2f : 0.5f, sender)
-        > sender->pointM.distanceTo(dynshape()->shape()->getPoint(m_step - 1))) {
+        > pt.distanceTo(dynshape()->shape()->getPoint(m_step - 1))) {
         return false;
     }
     
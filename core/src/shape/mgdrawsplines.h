@@ -31,13 +31,15 @@ private:
     virtual bool draw(const MgMotion* sender, GiGraphics* gs);
     virtual bool touchBegan(const MgMotion* sender);
     virtual bool touchMoved(const MgMotion* sender);
+    virtual bool touchMovedPoints(const MgMotion* sender, UInt32 count, const Point2d* points);
     virtual bool touchEnded(const MgMotion* sender);
     virtual bool click(const MgMotion* sender);
     virtual bool doubleClick(const MgMotion* sender);
     virtual bool cancel(const MgMotion* sender);
+    virtual UInt32 getFixedCount();
     
 private:
-    bool canAddPoint(const MgMotion* sender, bool ended);
+    bool canAddPoint(const MgMotion* sender, const Point2d& pt, bool ended);
     
     bool    m_freehand;
 };
@@ -0,0 +1,93 @@
+//! \file mgfactory.h
+//! \brief 定义创建函数注册表类 MgFactoryTable
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+
+#ifndef __GEOMETRY_MGFACTORYTABLE_H_
+#define __GEOMETRY_MGFACTORYTABLE_H_
+
+#include <gisync.h>
+#include <string.h>
+
+//! 创建函数注册表类
+/*! 按整数键（图形类型号或命令名的散列值）开放定址存放创建函数，键为槽号时不冲突，
+    查找时不加锁，只对每个探测的槽原子读取一次键。注册和取消注册时加锁，
+    先写好名称和创建函数再发布键，已发布的槽不再移除，取消注册只清除创建函数。\n
+    只能定义为静态变量，依赖其零初始化，可在其他全局对象的构造函数中使用。
+    \ingroup GEOM_SHAPE
+*/
+template <class Creator, UInt32 kSlots>
+class MgFactoryTable
+{
+public:
+    //! 返回名称的散列值，不为0
+    static UInt32 hashName(const char* name)
+    {
+        UInt32 hash = 2166136261u;
+        for (; *name; name++)
+            hash = ((hash ^ (UInt8)*name) * 16777619u) & 0xFFFFFFFFu;   // FNV-1a
+        return hash ? hash : 1;
+    }
+
+    //! 查找创建函数，可在多个线程中同时调用
+    /*!
+        \param key 键，不为0
+        \param name 名称，为NULL时只比较键
+        \return 创建函数，没有注册或已取消注册时为NULL
+    */
+    Creator find(UInt32 key, const char* name = NULL) const
+    {
+        for (UInt32 i = 0; i < kSlots; i++) {
+            const Slot& slot = _slots[(key + i) & (kSlots - 1)];
+            const UInt32 k = (UInt32)giAtomicLoad(&slot.key);
+
+            if (0 == k)
+                break;
+            if (k == key && (!name || strcmp(slot.name, name) == 0))
+                return slot.creator;
+        }
+        return NULL;
+    }
+
+    //! 注册或取消注册创建函数
+    /*!
+        \param key 键，不为0
+        \param name 名称，为NULL时只比较键，否则复制保存
+        \param creator 创建函数，为NULL则取消注册
+        \return 是否注册成功，表满时失败
+    */
+    bool set(UInt32 key, const char* name, Creator creator)
+    {
+        GiMutexLock locker(_mutex);
+
+        for (UInt32 i = 0; i < kSlots; i++) {
+            Slot& slot = _slots[(key + i) & (kSlots - 1)];
+
+            if (0 == slot.key) {
+                if (!creator)
+                    return true;
+                slot.name = name ? strcpy(new char[strlen(name) + 1], name) : NULL;
+                slot.creator = creator;
+                giInterlockedExchange(&slot.key, (long)key);
+                return true;
+            }
+            if ((UInt32)slot.key == key && (!name || strcmp(slot.name, name) == 0)) {
+                slot.creator = creator;
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    struct Slot {
+        volatile long       key;        // 为0表示空槽
+        const char*         name;       // 复制的名称，不释放
+        Creator volatile    creator;    // 为NULL表示已取消注册
+    };
+
+    Slot        _slots[kSlots];         // 槽数为2的幂
+    GiMutex     _mutex;                 // 注册时互斥
+};
+
+#endif // __GEOMETRY_MGFACTORYTABLE_H_
@@ -5,6 +5,8 @@
 #include "mggrid.h"
 #include <mgshape_.h>
 #include <mgstorage.h>
+#include <gidef.h>
+#include <vector>
 
 MG_IMPLEMENT_CREATE(MgGrid)
 
@@ -65,6 +67,48 @@ bool MgGrid::_setHandlePoint(UInt32 index, const Point2d& pt, float tol)
     return true;
 }
 
+//! 按像素间距抽稀网格线，返回网格线序号的步长: 1, 5, 25...
+static int gridStep(float cell, float minGap)
+{
+    int step = 1;
+    while (cell * step < minGap && step < 0x100000)
+        step *= 5;
+    return step;
+}
+
+//! 添加可见范围[vmin, vmax]内的网格线段，pts[1]为加粗的主网格线，pts[0]为次网格线
+static void addGridLines(std::vector<Point2d>* pts, bool vertical, float org, float cell, int n,
+                         float vmin, float vmax, float from, float to, bool switched, int step)
+{
+    int i0 = mgMax(0, (int)ceilf((vmin - org) / cell - _MGZERO));
+    int i1 = mgMin(n - 1, (int)floorf((vmax - org) / cell + _MGZERO));
+    
+    for (int i = (i0 + step - 1) / step * step; i <= i1; i += step) {
+        float v = org + cell * i;
+        std::vector<Point2d>& arr = pts[switched && i % 5 == 0 ? 1 : 0];
+        
+        arr.push_back(vertical ? Point2d(v, from) : Point2d(from, v));
+        arr.push_back(vertical ? Point2d(v, to) : Point2d(to, v));
+    }
+}
+
+//! 将多条线段作为一个路径显示
+static int drawSegments(GiGraphics& gs, const GiContext& ctx, const std::vector<Point2d>& pts)
+{
+    const int maxCount = 0x2000;
+    std::vector<UInt8> types(mgMin((int)pts.size(), maxCount));
+    int ret = 0;
+    
+    for (size_t i = 0; i < types.size(); i++)
+        types[i] = (UInt8)(i % 2 ? kGiLineTo : kGiMoveTo);
+    for (size_t i = 0; i < pts.size(); i += maxCount) {
+        int count = mgMin((int)(pts.size() - i), maxCount);
+        ret += gs.drawPath(&ctx, count, &pts[i], &types.front()) ? 1 : 0;
+    }
+    
+    return ret;
+}
+
 bool MgGrid::_draw(GiGraphics& gs, const GiContext& ctx) const
 {
     Vector2d cell(m_cell == Vector2d() ? Vector2d(getWidth()/4, getHeight()/4) : m_cell / 2);
@@ -81,24 +125,24 @@ bool MgGrid::_draw(GiGraphics& gs, const GiContext& ctx) const
     
     int ret = gs.drawRect(&ctxgrid, rect) ? 1 : 0;
     
-    bool switchx = (nx >= 10 && cell.x < gs.xf().displayToModel(20, true));
-    bool switchy = (ny >= 10 && cell.y < gs.xf().displayToModel(20, true));
-    Point2d pts[2] = { rect.leftTop(), rect.leftBottom() };
-    
-    for (int i = 0; i < nx; i++) {
-        ctxgrid.setLineWidth(!switchx || i%5 > 0 ? w/2 : w);
-        ret += gs.drawLine(&ctxgrid, pts[0], pts[1]) ? 1 : 0;
-        pts[0].x += cell.x;
-        pts[1].x += cell.x;
-    }
-    
-    pts[0] = rect.leftBottom();
-    pts[1] = rect.rightBottom();
-    for (int j = 0; j < ny; j++) {
-        ctxgrid.setLineWidth(!switchy || j%5 > 0 ? w/2 : w);
-        ret += gs.drawLine(&ctxgrid, pts[0], pts[1]) ? 1 : 0;
-        pts[0].y += cell.y;
-        pts[1].y += cell.y;
+    Box2d clip(gs.getClipModel());
+    if (clip.isIntersect(rect)) {
+        clip.intersectWith(rect);                       // 只显示可见部分的网格线
+        
+        bool switchx = (nx >= 10 && cell.x < gs.xf().displayToModel(20, true));
+        bool switchy = (ny >= 10 && cell.y < gs.xf().displayToModel(20, true));
+        float minGap = gs.xf().displayToModel(4);       // 网格线的最小像素间距
+        std::vector<Point2d> pts[2];
+        
+        addGridLines(pts, true, rect.xmin, cell.x, nx, clip.xmin, clip.xmax,
+                     clip.ymax, clip.ymin, switchx, gridStep(cell.x, minGap));
+        addGridLines(pts, false, rect.ymin, cell.y, ny, clip.ymin, clip.ymax,
+                     clip.xmin, clip.xmax, switchy, gridStep(cell.y, minGap));
+        
+        ctxgrid.setLineWidth(w/2);
+        ret += drawSegments(gs, ctxgrid, pts[0]);
+        ctxgrid.setLineWidth(w);
+        ret += drawSegments(gs, ctxgrid, pts[1]);
     }
     
     return __super::_draw(gs, ctx) || ret > 0;
@@ -132,19 +176,21 @@ int MgGrid::snap(Point2d& pnt, float& distx, float& disty)
     distx *= 3;
     disty *= 3;
     
-    for (float x = cell.x; x < getWidth() - _MGZERO; x += cell.x) {        
-        if (distx > fabs(pnt.x - (org.x + x))) {
-            newpt.x = org.x + x;
-            distx = (float)fabs(pnt.x - newpt.x);
-            ret |= 1;
-        }
+    // 直接算出最近的内部网格线序号，距离相等时取前一条
+    int nx = (int)ceilf((getWidth() - _MGZERO) / cell.x) - 1;
+    int ny = (int)ceilf((getHeight() - _MGZERO) / cell.y) - 1;
+    int ix = mgMax(1, mgMin(nx, (int)ceilf((pnt.x - org.x) / cell.x - 0.5f)));
+    int iy = mgMax(1, mgMin(ny, (int)ceilf((pnt.y - org.y) / cell.y - 0.5f)));
+    
+    if (nx > 0 && distx > fabs(pnt.x - (org.x + cell.x * ix))) {
+        newpt.x = org.x + cell.x * ix;
+        distx = (float)fabs(pnt.x - newpt.x);
+        ret |= 1;
     }
-    for (float y = cell.y; y < getHeight() - _MGZERO; y += cell.y) {
-        if (disty > fabs(pnt.y - (org.y + y))) {
-            newpt.y = org.y + y;
-            disty = (float)fabs(pnt.y - newpt.y);
-            ret |= 2;
-        }
+    if (ny > 0 && disty > fabs(pnt.y - (org.y + cell.y * iy))) {
+        newpt.y = org.y + cell.y * iy;
+        disty = (float)fabs(pnt.y - newpt.y);
+        ret |= 2;
     }
     
     pnt = newpt;
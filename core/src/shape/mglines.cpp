@@ -6,12 +6,17 @@
 #include <mgshape_.h>
 #include <mgnear.h>
 #include <mgstorage.h>
+#include <mglnrel.h>
+#include "mgsegidx.h"
+#include "mgpackpts.h"
+
+static GiMutex s_segIndexMutex;         // 建立线段索引时互斥，很少发生，各图形共用
 
 // MgBaseLines
 //
 
 MgBaseLines::MgBaseLines()
-    : _points(NULL), _maxCount(0), _count(0)
+    : _points(NULL), _maxCount(0), _count(0), _segIndex(NULL), _packed(NULL)
 {
 }
 
@@ -19,6 +24,10 @@ MgBaseLines::~MgBaseLines()
 {
     if (_points)
         delete[] _points;
+    if (_segIndex)
+        delete _segIndex;
+    if (_packed)
+        delete _packed;
 }
 
 UInt32 MgBaseLines::_getPointCount() const
@@ -28,20 +37,42 @@ UInt32 MgBaseLines::_getPointCount() const
 
 Point2d MgBaseLines::_getPoint(UInt32 index) const
 {
-    return index < _count ? _points[index] : Point2d();
+    if (index >= _count)
+        return Point2d();
+    return _packed ? _packed->point(index) : _points[index];
 }
 
 void MgBaseLines::_setPoint(UInt32 index, const Point2d& pt)
 {
+    unpack();
     if (index < _count)
         _points[index] = pt;
+    if (_segIndex)
+        _segIndex->invalidate();
 }
 
 void MgBaseLines::_copy(const MgBaseLines& src)
 {
-    resize(src._count);
-    for (UInt32 i = 0; i < _count; i++)
-        _points[i] = src._points[i];
+    if (_packed) {                      // 不必解码原来的顶点
+        delete _packed;
+        _packed = NULL;
+        _count = 0;
+    }
+    if (src._packed) {                  // 复制后仍为压缩存储
+        _packed = new MgPackedPoints(*src._packed);
+        _count = src._count;
+        if (_points)
+            delete[] _points;
+        _points = NULL;
+        _maxCount = 0;
+    }
+    else {
+        resize(src._count);
+        for (UInt32 i = 0; i < _count; i++)
+            _points[i] = src._points[i];
+    }
+    if (_segIndex)
+        _segIndex->invalidate();
 
     __super::_copy(src);
 }
@@ -53,7 +84,7 @@ bool MgBaseLines::_equals(const MgBaseLines& src) const
 
     for (UInt32 i = 0; i < _count; i++)
     {
-        if (_points[i] != src._points[i])
+        if (_getPoint(i) != src._getPoint(i))
             return false;
     }
 
@@ -67,30 +98,123 @@ bool MgBaseLines::_isKindOf(UInt32 type) const
 
 void MgBaseLines::_update()
 {
-    _extent.set(_count, _points);
+    if (_packed)                        // 按量化坐标计算，不必解码
+        _extent = _packed->extent();
+    else
+        _extent.set(_count, _points);
+    if (_segIndex)                      // 到第一次点中时再建立
+        _segIndex->invalidate();
     __super::_update();
 }
 
 void MgBaseLines::_transform(const Matrix2d& mat)
 {
+    unpack();
     for (UInt32 i = 0; i < _count; i++)
         _points[i] *= mat;
+    if (_segIndex)
+        _segIndex->invalidate();
     __super::_transform(mat);
 }
 
 void MgBaseLines::_clear()
 {
     _count = 0;
+    if (_packed) {
+        delete _packed;
+        _packed = NULL;
+    }
+    if (_segIndex)
+        _segIndex->invalidate();
     __super::_clear();
 }
 
+// 顶点很多时在第一次点中时建立索引，多个线程可同时点中同一图形，
+// 索引有效时不加锁直接使用，否则互斥地建立，图形的修改都在写锁定期间进行
+const MgSegmentIndex* MgBaseLines::_getSegmentIndex() const
+{
+    if (_packed || _count < MgSegmentIndex::kMinPoints)
+        return NULL;
+    
+    MgSegmentIndex* index = _segIndex;
+    if (index && index->valid() && index->closed() == isClosed())
+        return index;
+    
+    GiMutexLock locker(s_segIndexMutex);
+    
+    index = _segIndex;
+    if (!index)
+        index = new MgSegmentIndex();
+    if (!index->valid() || index->closed() != isClosed())
+        index->build(_count, _points, isClosed());
+    _segIndex = index;                  // 建立完成后才发布
+    
+    return index;
+}
+
 Point2d MgBaseLines::endPoint() const
 {
-    return _count > 0 ? _points[_count - 1] : Point2d();
+    return _count > 0 ? _getPoint(_count - 1) : Point2d();
+}
+
+UInt32 MgBaseLines::copyPoints(UInt32 from, UInt32 count, Point2d* points) const
+{
+    if (from >= _count)
+        return 0;
+    count = mgMin(count, _count - from);
+    if (_packed) {
+        _packed->unpack(from, count, points);
+    }
+    else {
+        for (UInt32 i = 0; i < count; i++)
+            points[i] = _points[from + i];
+    }
+    return count;
+}
+
+const Point2d* MgBaseLines::_pointsFor(MgDecodeBuffer& buf) const
+{
+    if (!_packed)
+        return _points;
+    Point2d* points = buf.points(_count);
+    _packed->unpack(0, _count, points);
+    return points;
+}
+
+bool MgBaseLines::_pack()
+{
+    if (_packed)
+        return true;
+    if (0 == _count)
+        return false;
+    
+    Box2d rect;
+    rect.set(_count, _points);
+    _packed = new MgPackedPoints();
+    _packed->pack(_count, _points, rect);
+    
+    delete[] _points;
+    _points = NULL;
+    _maxCount = 0;
+    if (_segIndex) {                    // 索引与顶点数组一样大，不再保留
+        delete _segIndex;
+        _segIndex = NULL;
+    }
+    return true;
+}
+
+void MgBaseLines::_unpack()
+{
+    _maxCount = (_count + 7) / 8 * 8;
+    _points = new Point2d[_maxCount];
+    _packed->unpack(0, _count, _points);
+    delete _packed;
+    _packed = NULL;
 }
 
 bool MgBaseLines::resize(UInt32 count)
 {
+    unpack();
     if (_maxCount < count)
     {
         _maxCount = (count + 7) / 8 * 8;
@@ -104,6 +228,8 @@ bool MgBaseLines::resize(UInt32 count)
         _points = pts;
     }
     _count = count;
+    if (_segIndex)
+        _segIndex->invalidate();
     return true;
 }
 
@@ -133,11 +259,14 @@ bool MgBaseLines::removePoint(UInt32 index)
 {
     bool ret = false;
     
+    unpack();
     if (index < _count && _count > 1)
     {
         for (UInt32 i = index + 1; i < _count; i++)
             _points[i - 1] = _points[i];
         _count--;
+        if (_segIndex)
+            _segIndex->invalidate();
         ret = true;
     }
     
@@ -168,10 +297,140 @@ bool MgBaseLines::_setHandlePoint(UInt32 index, const Point2d& pt, float tol)
     return true;
 }
 
+// 找出给定点附近的最近线段
+struct NearestSegment {
+    const Point2d*  points;
+    UInt32          count;
+    Point2d         pt;
+    float           tol;
+    float           dist;
+    Point2d         nearpt;
+    Int32           segment;
+    
+    bool operator()(UInt32 i) {
+        Point2d ptTemp;
+        float d = mgPtToLine(points[i], points[(i + 1) % count], pt, ptTemp);
+        if (d <= tol && d < dist) {
+            dist = d;
+            nearpt = ptTemp;
+            segment = i;
+        }
+        return true;
+    }
+};
+
+// 同 mgPtInArea ，判断点是否与多边形的顶点重合或在边上
+struct PtOnBoundary {
+    const Point2d*  points;
+    UInt32          count;
+    Point2d         pt;
+    Int32           vertex;
+    Int32           edge;
+    
+    bool operator()(UInt32 i) {
+        if (pt.isEqualTo(points[i]) && (vertex < 0 || (Int32)i < vertex))
+            vertex = i;
+        const Point2d& p2 = points[(i + 1) % count];
+        if (points[i] != p2                         // 同 mgPtInArea 跳过零长度边
+            && mgIsBetweenLine2(points[i], p2, pt, Tol::gTol())
+            && (edge < 0 || (Int32)i < edge))
+            edge = i;
+        return true;
+    }
+};
+
+// 同 mgPtInArea ，统计从Y负无穷大向上到点的射线与多边形的交点数
+struct PtCrossEdges {
+    const Point2d*  points;
+    UInt32          count;
+    Point2d         pt;
+    bool            odd;
+    
+    bool operator()(UInt32 i) {
+        const Point2d& p1 = points[i];
+        const Point2d& p2 = points[(i + 1) % count];
+        const Point2d& p0 = points[i > 0 ? i - 1 : count - 1];
+        
+        if (!((p2.x > p1.x) && (pt.x >= p1.x) && (pt.x < p2.x)) &&
+            !((p1.x > p2.x) && (pt.x <= p1.x) && (pt.x > p2.x)) )
+            return true;
+        
+        float yy = p1.y + (pt.x - p1.x) * (p2.y - p1.y) / (p2.x - p1.x);
+        if (pt.y > yy) {
+            if (mgIsZero(pt.x - p1.x)
+                && (((p0.x > pt.x) && (p2.x > pt.x)) || ((p0.x < pt.x) && (p2.x < pt.x))))
+                return true;
+            odd = !odd;
+        }
+        return true;
+    }
+};
+
+struct AnySegment {
+    bool operator()(UInt32) { return false; }
+};
+
 float MgBaseLines::_hitTest(const Point2d& pt, float tol, 
                             Point2d& nearpt, Int32& segment) const
 {
-    return mgLinesHit(_count, _points, isClosed(), pt, tol, nearpt, segment);
+    const MgSegmentIndex* index = _getSegmentIndex();
+    if (!index && _packed && !isClosed()) {     // 分段解码到栈上的数组中，结果与整体检查相同
+        const UInt32 step = MgDecodeBuffer::kStackPoints - 1;
+        MgDecodeBuffer buf;
+        Point2d* points = buf.points(MgDecodeBuffer::kStackPoints);
+        float dist = _FLT_MAX;
+        
+        for (UInt32 from = 0; from + 1 < _count || from == 0; from += step) {
+            const UInt32 n = mgMin(step + 1, _count - from);
+            Point2d pt2;
+            Int32 seg = -1;
+            _packed->unpack(from, n, points);
+            const float d = mgLinesHit(n, points, false, pt, tol, pt2, seg);
+            if (d < dist) {                     // 距离相同时取前面的线段
+                dist = d;
+                nearpt = pt2;
+                segment = seg + from;
+            }
+        }
+        return dist;
+    }
+    if (!index) {
+        MgDecodeBuffer buf;
+        return mgLinesHit(_count, _pointsFor(buf), isClosed(), pt, tol, nearpt, segment);
+    }
+    
+    // 与 mgLinesHit 相同，只是用线段索引代替逐段检查
+    if (isClosed()) {
+        const float eps = Tol::gTol().equalPoint();
+        PtOnBoundary onb = { _points, _count, pt, -1, -1 };
+        index->query(Box2d(pt, 2 * eps, 2 * eps), _count, _points, onb);
+        
+        if (onb.vertex >= 0) {
+            segment = onb.vertex;
+            nearpt = _points[segment];
+            return nearpt.distanceTo(pt);
+        }
+        if (onb.edge >= 0) {
+            segment = onb.edge;
+            return mgPtToLine(_points[segment], _points[(segment + 1) % _count], pt, nearpt);
+        }
+        
+        PtCrossEdges cross = { _points, _count, pt, false };
+        index->query(Box2d(pt.x, _extent.ymin, pt.x, pt.y), _count, _points, cross);
+        if (!cross.odd) {
+            segment = -1;
+            return _FLT_MAX;
+        }
+    }
+    
+    NearestSegment nearest = { _points, _count, pt, tol, _FLT_MAX, Point2d(), -1 };
+    index->query(Box2d(pt, 2 * tol, 2 * tol), _count, _points, nearest);
+    if (nearest.segment >= 0)
+        nearpt = nearest.nearpt;
+    if (nearest.segment >= 0 || isClosed())
+        segment = nearest.segment;
+    
+    return nearest.dist;
 }
 
 bool MgBaseLines::_hitTestBox(const Box2d& rect) const
@@ -179,6 +438,23 @@ bool MgBaseLines::_hitTestBox(const Box2d& rect) const
     if (!__super::_hitTestBox(rect))
         return false;
     
+    const MgSegmentIndex* index = _getSegmentIndex();
+    if (index) {
+        AnySegment visitor;
+        return !index->query(rect, _count, _points, visitor);
+    }
+    
+    if (_packed) {                      // 逐点解码，不必解码到数组中
+        Point2d prev (_packed->point(0));
+        for (UInt32 i = 1; i < _count; i++) {
+            const Point2d pt (_packed->point(i));
+            if (Box2d(prev, pt).isIntersect(rect))
+                return true;
+            prev = pt;
+        }
+        return _count < 2;
+    }
+    
     for (UInt32 i = 0; i + 1 < _count; i++) {
         if (Box2d(_points[i], _points[i + 1]).isIntersect(rect))
             return true;
@@ -187,11 +463,27 @@ bool MgBaseLines::_hitTestBox(const Box2d& rect) const
     return _count < 2;
 }
 
+bool MgBaseLines::_drawPart(GiGraphics& gs, const GiContext& ctx, UInt32 from, UInt32 to) const
+{
+    if (!(from < to && to < _count))
+        return false;
+    if (!_packed)
+        return gs.drawLines(&ctx, to - from + 1, _points + from);
+    
+    MgDecodeBuffer buf;
+    Point2d* points = buf.points(to - from + 1);
+    _packed->unpack(from, to - from + 1, points);
+    return gs.drawLines(&ctx, to - from + 1, points);
+}
+
 bool MgBaseLines::_save(MgStorage* s) const
 {
     bool ret = __super::_save(s);
     s->writeUInt32("count", _count);
-    s->writeFloatArray("points", (const float*)_points, _count * 2);
+    if (_packed)
+        _packed->save(s);
+    else
+        s->writeFloatArray("points", (const float*)_points, _count * 2);
     return ret;
 }
 
@@ -200,9 +492,30 @@ bool MgBaseLines::_load(MgStorage* s)
     bool ret = __super::_load(s);
     
     UInt32 n = s->readUInt32("count", 0);
-    if (n < 1 || n > 9999)
+    if (n < 1 || n > 0x3FFFFFFF)                    // 顶点数不限，只防止坐标个数溢出
         return false;
     
+    if (MgPackedPoints::isSaved(s, n)) {            // 压缩存储的顶点
+        MgPackedPoints* packed = new MgPackedPoints();
+        if (!packed->load(s, n)) {
+            delete packed;
+            return false;
+        }
+        if (_packed)
+            delete _packed;
+        if (_points)
+            delete[] _points;
+        _points = NULL;
+        _maxCount = 0;
+        _packed = packed;
+        _count = n;
+        if (_segIndex)
+            _segIndex->invalidate();
+        return ret;
+    }
+    
+    if (n > 9999 && s->readFloatArray("points", NULL, 0) < (int)n * 2)
+        return false;                               // 顶点很多时先检查坐标个数再按 count 分配
     resize(n);
     n = s->readFloatArray("points", (float*)_points, _count * 2);
     
@@ -224,10 +537,13 @@ MgLines::~MgLines()
 
 bool MgLines::_draw(GiGraphics& gs, const GiContext& ctx) const
 {
+    MgDecodeBuffer buf;
+    const Point2d* points = _pointsFor(buf);
     bool ret = false;
+    
     if (isClosed())
-        ret = gs.drawPolygon(&ctx, _count, _points);
+        ret = gs.drawPolygon(&ctx, _count, points);
     else
-        ret = gs.drawLines(&ctx, _count, _points);
+        ret = gs.drawLines(&ctx, _count, points);
     return __super::_draw(gs, ctx) || ret;
 }
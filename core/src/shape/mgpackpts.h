@@ -0,0 +1,265 @@
+//! \file mgpackpts.h
+//! \brief 定义顶点压缩存储类 MgPackedPoints
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+
+#ifndef __GEOMETRY_MGPACKEDPOINTS_H_
+#define __GEOMETRY_MGPACKEDPOINTS_H_
+
+#include <mgbox.h>
+#include <mgstorage.h>
+#include <vector>
+
+//! 顶点压缩存储类
+/*! 以包络框中心为局部原点，按包络框的长边将顶点坐标量化为16位整数，每点由8字节降为4字节，
+    量化误差约为包络框长边的 1/(4*kMaxValue)，是有损压缩。各点定长存放，可按序号直接解码。
+    也可用于样条曲线的切矢量等二维矢量。\n
+    保存时写出相邻点的整数增量，按各增量所需的位数紧凑排列，连续笔画每点约占一个多浮点数，
+    少于浮点坐标的两个。
+    \ingroup GEOM_SHAPE
+*/
+class MgPackedPoints
+{
+public:
+    enum {
+        kMaxValue = 32767           //!< 量化坐标的最大绝对值
+    };
+
+    MgPackedPoints() : m_step(1) {}
+
+    //! 返回顶点数
+    UInt32 count() const { return (UInt32)(m_xy.size() / 2); }
+
+    //! 量化顶点或矢量
+    /*!
+        \param count 顶点数
+        \param points 顶点数组，也可为 Vector2d 数组
+        \param extent 各点的包络框
+    */
+    template <class PointT>
+    void pack(UInt32 count, const PointT* points, const Box2d& extent)
+    {
+        m_origin = extent.center();
+        m_step = mgMax(extent.width(), extent.height()) / (2 * kMaxValue);
+        if (!(m_step > 0))                  // 各点重合
+            m_step = 1;
+        m_xy.resize(count * 2);
+
+        const float f = 1 / m_step;
+        for (UInt32 i = 0; i < count; i++) {
+            m_xy[2 * i] = quantize((points[i].x - m_origin.x) * f);
+            m_xy[2 * i + 1] = quantize((points[i].y - m_origin.y) * f);
+        }
+    }
+
+    //! 解码一个顶点
+    Point2d point(UInt32 index) const
+    {
+        return Point2d(m_origin.x + m_xy[2 * index] * m_step,
+                       m_origin.y + m_xy[2 * index + 1] * m_step);
+    }
+
+    //! 返回各顶点的包络框，不必解码，与解码后的顶点的包络框相同
+    Box2d extent() const
+    {
+        if (m_xy.empty())
+            return Box2d();
+
+        Int16 xmin = m_xy[0], ymin = m_xy[1], xmax = xmin, ymax = ymin;
+        for (size_t i = 2; i + 1 < m_xy.size(); i += 2) {
+            xmin = mgMin(xmin, m_xy[i]);
+            xmax = mgMax(xmax, m_xy[i]);
+            ymin = mgMin(ymin, m_xy[i + 1]);
+            ymax = mgMax(ymax, m_xy[i + 1]);
+        }
+        return Box2d(point(xmin, ymin), point(xmax, ymax));
+    }
+
+    //! 解码从 from 开始的 count 个顶点或矢量
+    template <class PointT>
+    void unpack(UInt32 from, UInt32 count, PointT* points) const
+    {
+        const Int16* xy = &m_xy[2 * from];
+        for (UInt32 i = 0; i < count; i++, xy += 2) {
+            points[i].set(m_origin.x + xy[0] * m_step, m_origin.y + xy[1] * m_step);
+        }
+    }
+
+    //! 保存局部原点、量化步长和相邻坐标的整数增量
+    /*! 各增量按 zigzag 转为非负整数后以定长 bits 位连续排列，每个浮点数存放24位，
+        各值都可用浮点数精确表示。第一点的增量相对于局部原点。
+    */
+    void save(MgStorage* s) const
+    {
+        const UInt32 n = (UInt32)m_xy.size();
+        UInt32 maxcode = 0;
+        int bits = 1;
+
+        for (UInt32 i = 0; i < n; i++)
+            maxcode = mgMax(maxcode, zigzag(i));
+        while (maxcode >> bits)
+            bits++;
+
+        std::vector<float> words;
+        UInt32 word = 0;
+        int used = 0;
+
+        words.reserve(wordCount(n / 2, bits));
+        for (UInt32 i = 0; i < n; i++) {
+            const UInt32 code = zigzag(i);
+            for (int left = bits; left > 0; ) {
+                const int k = mgMin(left, kWordBits - used);
+                left -= k;
+                used += k;
+                word |= ((code >> left) & ((1UL << k) - 1)) << (kWordBits - used);
+                if (used == kWordBits) {
+                    words.push_back((float)word);
+                    word = 0;
+                    used = 0;
+                }
+            }
+        }
+        if (used > 0)
+            words.push_back((float)word);
+
+        s->writeFloatArray("origin", &m_origin.x, 2);
+        s->writeFloat("step", m_step);
+        s->writeUInt8("bits", (UInt8)bits);
+        s->writeFloatArray("deltas", words.empty() ? NULL : &words.front(), (int)words.size());
+    }
+
+    //! 返回是否有 save() 保存的 count 个点的增量数组
+    static bool isSaved(MgStorage* s, UInt32 count)
+    {
+        const int bits = s->readUInt8("bits", 0);
+        return count > 0 && bits > 0 && bits <= kMaxBits
+            && s->readFloatArray("deltas", NULL, 0) == (int)wordCount(count, bits);
+    }
+
+    //! 读取 save() 保存的内容
+    /*!
+        \param s 存取对象
+        \param count 顶点数
+        \return 是否读取成功，没有增量字段或内容无效时失败
+    */
+    bool load(MgStorage* s, UInt32 count)
+    {
+        if (!isSaved(s, count))
+            return false;
+
+        const int bits = s->readUInt8("bits", 0);
+        std::vector<float> words(wordCount(count, bits));
+        if (s->readFloatArray("deltas", &words.front(), (int)words.size()) != (int)words.size())
+            return false;
+        if (s->readFloatArray("origin", &m_origin.x, 2) != 2)
+            return false;
+        m_step = s->readFloat("step", 0);
+        if (!(m_step > 0))
+            return false;
+
+        size_t k = 0;
+        UInt32 word = 0;
+        int avail = 0;
+
+        m_xy.resize(count * 2);
+        for (UInt32 i = 0; i < count * 2; i++) {
+            UInt32 code = 0;
+            for (int left = bits; left > 0; ) {
+                if (avail == 0) {
+                    const float w = words[k++];
+                    if (!(w >= 0 && w < (1 << kWordBits)) || w != (float)(UInt32)w)
+                        return false;
+                    word = (UInt32)w;
+                    avail = kWordBits;
+                }
+                const int n = mgMin(left, avail);
+                left -= n;
+                avail -= n;
+                code = (code << n) | ((word >> avail) & ((1UL << n) - 1));
+            }
+
+            const long v = (i < 2 ? 0 : m_xy[i - 2])
+                + ((code & 1) ? -(long)(code >> 1) - 1 : (long)(code >> 1));
+            if (v < -kMaxValue || v > kMaxValue)
+                return false;
+            m_xy[i] = (Int16)v;
+        }
+        return true;
+    }
+
+private:
+    enum {
+        kWordBits = 24,             // 每个浮点数存放的位数
+        kMaxBits = 17               // 每个增量的最大位数
+    };
+
+    static UInt32 wordCount(UInt32 count, int bits)
+    {
+        return (count * 2 * bits + kWordBits - 1) / kWordBits;
+    }
+
+    // 第 i 个坐标与前一点同一坐标的增量，正负交替映射为非负整数
+    UInt32 zigzag(UInt32 i) const
+    {
+        const long d = m_xy[i] - (i < 2 ? 0 : m_xy[i - 2]);
+        return d < 0 ? (UInt32)(-2 * d - 1) : (UInt32)(2 * d);
+    }
+
+    // 按与 unpack() 相同的算式解码量化坐标，坐标越大解码后也不会越小
+    Point2d point(Int16 x, Int16 y) const
+    {
+        return Point2d(m_origin.x + x * m_step, m_origin.y + y * m_step);
+    }
+
+    static Int16 quantize(float value)
+    {
+        long n = mgRound(value);
+        return (Int16)(n < -kMaxValue ? -kMaxValue : (n > kMaxValue ? kMaxValue : n));
+    }
+
+private:
+    Point2d             m_origin;       // 局部原点，包络框中心
+    float               m_step;         // 量化步长
+    std::vector<Int16>  m_xy;           // 量化后的坐标，x、y交替
+};
+
+//! 解码顶点或矢量用的临时数组
+/*! 作为局部变量使用，点数不多时用栈上的数组，不必每次显示和点中时分配内存，
+    点数多时才分配堆内存。各次调用各用各的，可在多个线程中同时使用。
+    \ingroup GEOM_SHAPE
+*/
+class MgDecodeBuffer
+{
+public:
+    enum {
+        kStackPoints = 512          //!< 栈上数组的点数，占4KB
+    };
+
+    MgDecodeBuffer() : m_heap(NULL) {}
+    ~MgDecodeBuffer() { if (m_heap) delete[] m_heap; }
+
+    //! 返回可存放 count 个顶点的数组，不保留原来的内容
+    Point2d* points(UInt32 count) { return (Point2d*)alloc(count); }
+
+    //! 返回可存放 count 个矢量的数组，不保留原来的内容
+    Vector2d* vectors(UInt32 count) { return (Vector2d*)alloc(count); }
+
+private:
+    float* alloc(UInt32 count)
+    {
+        if (count <= kStackPoints)
+            return m_local;
+        if (m_heap)
+            delete[] m_heap;
+        m_heap = new float[count * 2];
+        return m_heap;
+    }
+
+    MgDecodeBuffer(const MgDecodeBuffer&);
+    void operator=(const MgDecodeBuffer&);
+
+    float       m_local[kStackPoints * 2];  // 不用 Point2d 数组，不必逐个构造
+    float*      m_heap;
+};
+
+#endif // __GEOMETRY_MGPACKEDPOINTS_H_
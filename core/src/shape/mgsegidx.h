@@ -0,0 +1,136 @@
+//! \file mgsegidx.h
+//! \brief 定义折线分段包络框索引类 MgSegmentIndex
+// Copyright (c) 2004-2012, Zhang Yungui
+// License: LGPL, https://github.com/rhcad/touchvg
+
+#ifndef __GEOMETRY_MGSEGMENTINDEX_H_
+#define __GEOMETRY_MGSEGMENTINDEX_H_
+
+#include <mgbox.h>
+#include <gisync.h>
+#include <vector>
+
+//! 折线分段包络框索引类
+/*! 折线的相邻线段在空间上也相邻，因此按线段顺序每 kLeafSize 段合为一个叶结点，
+    每 kFanout 个结点再合为上一层结点，查询时自顶向下只进入与查询框相交的结点。
+    \ingroup GEOM_SHAPE
+*/
+class MgSegmentIndex
+{
+public:
+    enum {
+        kLeafSize = 8,          //!< 叶结点的线段数
+        kFanout = 4,            //!< 上层结点的子结点数
+        kMinPoints = 256        //!< 顶点数少于此值时不必建立索引
+    };
+
+    MgSegmentIndex() : m_segs(0), m_closed(false), m_valid(0) {}
+
+    //! 返回索引是否有效，读到有效时建立索引的结果已对本线程可见
+    bool valid() const { return giAtomicLoad(&m_valid) != 0; }
+
+    //! 返回建立索引时折线是否闭合
+    bool closed() const { return m_closed; }
+
+    //! 标记索引已失效，下次查询前需要重新建立
+    void invalidate() { giInterlockedExchange(&m_valid, 0); }
+
+    //! 按折线的顶点建立索引，建立完成后才发布为有效
+    void build(UInt32 count, const Point2d* points, bool closed)
+    {
+        invalidate();
+        m_segs = count < 2 ? 0 : (closed ? count : count - 1);
+        m_closed = closed;
+        m_levels.resize(1);
+        m_levels[0].clear();
+
+        for (UInt32 i = 0; i < m_segs; i += kLeafSize) {
+            UInt32 end = mgMin(i + (UInt32)kLeafSize, m_segs);
+            Box2d box(points[i], points[(i + 1) % count]);
+            for (UInt32 j = i + 1; j < end; j++)
+                merge(box, Box2d(points[j], points[(j + 1) % count]));
+            m_levels[0].push_back(box);
+        }
+        while (m_levels.back().size() > kFanout) {
+            const std::vector<Box2d>& lower = m_levels.back();
+            std::vector<Box2d> upper;
+            for (size_t i = 0; i < lower.size(); i += kFanout) {
+                Box2d box(lower[i]);
+                for (size_t j = i + 1; j < i + kFanout && j < lower.size(); j++)
+                    merge(box, lower[j]);
+                upper.push_back(box);
+            }
+            m_levels.push_back(upper);
+        }
+        giInterlockedExchange(&m_valid, 1);
+    }
+
+    //! 查找包络框与给定矩形相交的线段
+    /*!
+        \param rect 查询矩形，必须为规范化矩形
+        \param count 折线的顶点数，与建立索引时的相同
+        \param points 折线的顶点数组
+        \param visitor 对每个线段号调用 visitor(i)，返回false时停止查找
+        \return 是否已遍历完（visitor 未要求停止）
+    */
+    template<class Visitor>
+    bool query(const Box2d& rect, UInt32 count, const Point2d* points, Visitor& visitor) const
+    {
+        if (m_segs == 0)
+            return true;
+
+        const std::vector<Box2d>& top = m_levels.back();
+        for (UInt32 k = 0; k < top.size(); k++) {
+            if (!visit((UInt32)m_levels.size() - 1, k, rect, count, points, visitor))
+                return false;
+        }
+        return true;
+    }
+
+private:
+    // 不用 Box2d::unionWith，水平或竖直线段的包络框高或宽为零，也要合并
+    static void merge(Box2d& box, const Box2d& other)
+    {
+        box.xmin = mgMin(box.xmin, other.xmin);
+        box.ymin = mgMin(box.ymin, other.ymin);
+        box.xmax = mgMax(box.xmax, other.xmax);
+        box.ymax = mgMax(box.ymax, other.ymax);
+    }
+
+    static bool overlap(const Box2d& a, const Box2d& b)
+    {
+        return !(a.xmax < b.xmin || b.xmax < a.xmin || a.ymax < b.ymin || b.ymax < a.ymin);
+    }
+
+    template<class Visitor>
+    bool visit(UInt32 level, UInt32 k, const Box2d& rect,
+               UInt32 count, const Point2d* points, Visitor& visitor) const
+    {
+        if (!overlap(m_levels[level][k], rect))
+            return true;
+
+        if (level == 0) {
+            UInt32 end = mgMin((k + 1) * (UInt32)kLeafSize, m_segs);
+            for (UInt32 i = k * (UInt32)kLeafSize; i < end; i++) {
+                if (overlap(Box2d(points[i], points[(i + 1) % count]), rect) && !visitor(i))
+                    return false;
+            }
+        }
+        else {
+            UInt32 end = mgMin((k + 1) * (UInt32)kFanout, (UInt32)m_levels[level - 1].size());
+            for (UInt32 i = k * (UInt32)kFanout; i < end; i++) {
+                if (!visit(level - 1, i, rect, count, points, visitor))
+                    return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    std::vector<std::vector<Box2d> > m_levels;  // 各层结点的包络框，第0层为叶结点
+    UInt32      m_segs;                         // 线段数
+    bool        m_closed;                       // 折线是否闭合
+    volatile long m_valid;                      // 索引是否有效，用原子操作读取和发布
+};
+
+#endif // __GEOMETRY_MGSEGMENTINDEX_H_
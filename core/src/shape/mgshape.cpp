@@ -6,7 +6,7 @@
 #include <gigraph.h>
 #include <mgstorage.h>
 
-MgBaseShape::MgBaseShape() : _flags(0)
+MgBaseShape::MgBaseShape() : _flags(0), _changeCount(0)
 {
 }
 
@@ -33,6 +33,7 @@ bool MgBaseShape::_isKindOf(UInt32 type) const
 
 void MgBaseShape::_update()
 {
+    _changeCount++;
     if (!_extent.isNull()) {
         if (_extent.width() < Tol::gTol().equalPoint()) {
             _extent.inflate(Tol::gTol().equalPoint(), 0);
@@ -131,5 +132,9 @@ bool MgBaseShape::getFlag(MgShapeBit bit) const
 
 void MgBaseShape::setFlag(MgShapeBit bit, bool on)
 {
-    _flags = on ? _flags | (1 << bit) : _flags & ~(1 << bit);
+    UInt32 flags = on ? _flags | (1 << bit) : _flags & ~(1 << bit);
+    if (_flags != flags) {
+        _flags = flags;
+        _changeCount++;
+    }
 }
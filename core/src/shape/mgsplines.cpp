@@ -6,10 +6,11 @@
 #include <mgshape_.h>
 #include <mgnear.h>
 #include <mgcurv.h>
+#include "mgpackpts.h"
 
 MG_IMPLEMENT_CREATE(MgSplines)
 
-MgSplines::MgSplines() : _knotvs(NULL), _bzcount(0)
+MgSplines::MgSplines() : _knotvs(NULL), _bzcount(0), _packedKnots(NULL)
 {
 }
 
@@ -17,11 +18,28 @@ MgSplines::~MgSplines()
 {
     if (_knotvs)
         delete[] _knotvs;
+    if (_packedKnots)
+        delete _packedKnots;
 }
 
 void MgSplines::_update()
 {
     __super::_update();
+    
+    if (_packed) {                      // 按解码的顶点重新计算切矢量并压缩保留
+        MgDecodeBuffer points, buf;
+        Vector2d* knotvs = buf.vectors(_count);
+        const Point2d* pts = _pointsFor(points);
+        mgCubicSplines(_count, pts, knotvs, isClosed() ? kMgCubicLoop : 0);
+        mgCubicSplinesBox(_extent, _count, pts, knotvs);
+        _packKnots(knotvs);
+        if (_knotvs) {
+            delete[] _knotvs;
+            _knotvs = NULL;
+            _bzcount = 0;
+        }
+        return;
+    }
 
     if (_bzcount < _count)
     {
@@ -35,10 +53,67 @@ void MgSplines::_update()
     mgCubicSplinesBox(_extent, _count, _points, _knotvs);
 }
 
+bool MgSplines::_pack()
+{
+    if (_packed)
+        return true;
+    if (_knotvs && _count > 0)          // 切矢量也压缩，显示时不必重新计算
+        _packKnots(_knotvs);
+    if (!__super::_pack())
+        return false;
+    if (_knotvs) {
+        delete[] _knotvs;
+        _knotvs = NULL;
+        _bzcount = 0;
+    }
+    return true;
+}
+
+void MgSplines::_packKnots(const Vector2d* knotvs)
+{
+    Box2d rect (knotvs[0].x, knotvs[0].y, knotvs[0].x, knotvs[0].y);
+    for (UInt32 i = 1; i < _count; i++)
+        rect.unionWith(knotvs[i].x, knotvs[i].y);
+    
+    if (!_packedKnots)
+        _packedKnots = new MgPackedPoints();
+    _packedKnots->pack(_count, knotvs, rect);
+}
+
+void MgSplines::_unpack()
+{
+    __super::_unpack();
+    
+    if (_knotvs)
+        delete[] _knotvs;
+    if (_packedKnots) {
+        delete _packedKnots;
+        _packedKnots = NULL;
+    }
+    _bzcount = _maxCount;
+    _knotvs = new Vector2d[_bzcount];
+    mgCubicSplines(_count, _points, _knotvs, isClosed() ? kMgCubicLoop : 0);
+}
+
+const Vector2d* MgSplines::_knotvsFor(const Point2d* points, MgDecodeBuffer& buf) const
+{
+    if (!_packed)
+        return _knotvs;
+    Vector2d* knotvs = buf.vectors(_count);
+    if (_packedKnots && _packedKnots->count() == _count)
+        _packedKnots->unpack(0, _count, knotvs);
+    else
+        mgCubicSplines(_count, points, knotvs, isClosed() ? kMgCubicLoop : 0);
+    return knotvs;
+}
+
 float MgSplines::_hitTest(const Point2d& pt, float tol, 
                           Point2d& nearpt, Int32& segment) const
 {
-    return mgCubicSplinesHit(_count, _points, _knotvs, isClosed(), 
+    MgDecodeBuffer points, knotvs;
+    const Point2d* pts = _pointsFor(points);
+    
+    return mgCubicSplinesHit(_count, pts, _knotvsFor(pts, knotvs), isClosed(), 
         pt, tol, nearpt, segment);
 }
 
@@ -46,27 +121,55 @@ bool MgSplines::_hitTestBox(const Box2d& rect) const
 {
     if (!__super::_hitTestBox(rect))
         return false;
-    return mgCubicSplinesIntersectBox(rect, _count, _points, _knotvs, isClosed());
+    
+    MgDecodeBuffer points, knotvs;
+    const Point2d* pts = _pointsFor(points);
+    
+    return mgCubicSplinesIntersectBox(rect, _count, pts, _knotvsFor(pts, knotvs), isClosed());
 }
 
 bool MgSplines::_draw(GiGraphics& gs, const GiContext& ctx) const
 {
+    MgDecodeBuffer points, knotvs;
+    const Point2d* pts = _pointsFor(points);
     bool ret = false;
 
     if (_count == 2)
-        ret = gs.drawLine(&ctx, _points[0], _points[1]);
+        ret = gs.drawLine(&ctx, pts[0], pts[1]);
     else if (isClosed())
-        ret = gs.drawClosedSplines(&ctx, _count, _points, _knotvs);
+        ret = gs.drawClosedSplines(&ctx, _count, pts, _knotvsFor(pts, knotvs));
     else
-        ret = gs.drawSplines(&ctx, _count, _points, _knotvs);
+        ret = gs.drawSplines(&ctx, _count, pts, _knotvsFor(pts, knotvs));
 
     return __super::_draw(gs, ctx) || ret;
 }
 
+bool MgSplines::_drawPart(GiGraphics& gs, const GiContext& ctx, UInt32 from, UInt32 to) const
+{
+    if (!(from < to && to < _count))
+        return false;
+    
+    MgDecodeBuffer points, knotvs;
+    
+    if (_packed && _packedKnots && _packedKnots->count() == _count) {   // 只解码要显示的部分
+        const UInt32 n = to - from + 1;
+        Point2d* pts = points.points(n);
+        Vector2d* vs = knotvs.vectors(n);
+        _packed->unpack(from, n, pts);
+        _packedKnots->unpack(from, n, vs);
+        return gs.drawSplines(&ctx, n, pts, vs);
+    }
+    
+    const Point2d* pts = _pointsFor(points);
+    
+    return gs.drawSplines(&ctx, to - from + 1, pts + from, _knotvsFor(pts, knotvs) + from);
+}
+
 void MgSplines::smooth(float tol)
 {
     if (_count < 3)
         return;
+    unpack();
     
     Point2d* points = new Point2d[_count];
     Vector2d* knotvs = new Vector2d[_count];
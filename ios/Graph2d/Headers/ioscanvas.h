@@ -102,6 +102,10 @@ public:
     virtual bool rawLineTo(float x, float y);
     virtual bool rawBezierTo(const Point2d* pxs, int count);
     virtual bool rawClosePath();
+    virtual bool rawLinesBatch(const GiContext* ctx, int lineCount, 
+        const int* counts, const Point2d* pxs);
+    virtual bool rawBeziersBatch(const GiContext* ctx, int curveCount, 
+        const int* counts, const Point2d* pxs);
 
 private:
     GiCanvasIos();
@@ -9,6 +9,8 @@
 
 struct MgMotion;
 class MgViewProxy;
+class MgInputQueue;
+@class CADisplayLink;
 
 //! 命令控制器类，代理调用内部命令(MgCommand)
 /*! \ingroup GRAPH_IOS
@@ -21,6 +23,8 @@ class MgViewProxy;
     int         _clickFingers;      //!< 是否已触发单指点击或双击事件
     BOOL        _undoFired;         //!< 是否已触发Undo操作
     int         _touchCount;        //!< 开始触摸时的手指数
+    MgInputQueue    *_input;        //!< 单指滑动的采样点，在显示帧中一次处理
+    CADisplayLink   *_displayLink;  //!< 单指滑动期间的显示帧回调
 }
 
 @property (nonatomic)   const char*     commandName;    //!< 当前命令名称
@@ -3,7 +3,9 @@
 // License: LGPL, https://github.com/rhcad/touchvg
 
 #import "GiCmdController.h"
+#import <QuartzCore/QuartzCore.h>
 #include <mgselect.h>
+#include <mginput.h>
 #include <vector>
 #include <ioscanvas.h>
 #include <mgbasicsp.h>
@@ -15,6 +17,10 @@
 - (BOOL)getPointForPressDrag:(UIGestureRecognizer *)sender :(CGPoint*)point;
 - (GiContext*)currentContext;
 - (bool)longPressSelection:(int)selState shape:(MgShape*)shape;
+- (BOOL)queueInput:(CGPoint)point view:(UIView*)view;
+- (BOOL)flushInput;
+- (void)stopInput;
+- (void)inputFrame:(CADisplayLink*)link;
 
 @end
 
@@ -245,6 +251,49 @@ static long s_cmdRef = 0;
     return false;
 }
 
+- (BOOL)queueInput:(CGPoint)point view:(UIView*)view
+{
+    const float ms = (float)(CACurrentMediaTime() * 1000);
+    
+    [self setView:view];
+    if (!_input->push(Point2d(point.x, point.y), ms)) {     // 缓冲满时先处理已有的采样点
+        [self flushInput];
+        _input->push(Point2d(point.x, point.y), ms);
+    }
+    if (!_displayLink) {
+        _displayLink = [CADisplayLink displayLinkWithTarget:self selector:@selector(inputFrame:)];
+        [_displayLink addToRunLoop:[NSRunLoop mainRunLoop] forMode:NSRunLoopCommonModes];
+    }
+    
+    return YES;
+}
+
+- (BOOL)flushInput
+{
+    MgCommand* cmd = mgGetCommandManager()->getCommand();
+    
+    if (!cmd || _input->empty())
+        return NO;
+    _undoFired = false;                                     // 允许再触发Undo操作
+    
+    return _input->flush(_motion, cmd);
+}
+
+- (void)stopInput
+{
+    [self flushInput];
+    [_displayLink invalidate];                              // 不再引用本对象
+    _displayLink = nil;
+}
+
+- (void)inputFrame:(CADisplayLink*)link
+{
+    MgDynShapeLock locker;
+    
+    if (locker.locked())
+        [self flushInput];
+}
+
 @end
 
 @implementation GiCommandController
@@ -264,6 +313,7 @@ static long s_cmdRef = 0;
         _mgview = new MgViewProxy(self, auxviews);
         _motion = new MgMotion;
         _motion->view = _mgview;
+        _input = new MgInputQueue;
         s_cmdRef++;
     }
     return self;
@@ -274,6 +324,8 @@ static long s_cmdRef = 0;
     if (--s_cmdRef == 0) {
         mgGetCommandManager()->unloadCommands();
     }
+    [_displayLink invalidate];
+    delete _input;
     delete _motion;
     delete _mgview;
     [super dealloc];
@@ -458,6 +510,7 @@ static long s_cmdRef = 0;
             _motion->lastPointM = _motion->pointM;
             _motion->velocity = 0;
             _motion->pressDrag = false;
+            _input->reset(_motion->point, (float)(CACurrentMediaTime() * 1000));
             _moved = NO;
             _clickFingers = 0;
             _undoFired = NO;
@@ -536,11 +589,19 @@ static long s_cmdRef = 0;
             CGPoint velocity = [sender velocityInView:sender.view];
             _motion->velocity = hypotf(velocity.x, velocity.y);
             
-            ret = ([self getPointForPressDrag:sender :&point]
-                   && [self touchesMoved:point view:sender.view
-                                   count:sender.numberOfTouches]);
+            if ([self getPointForPressDrag:sender :&point]) {
+                if (_moved && !_motion->pressDrag && sender.numberOfTouches == 1) {
+                    ret = [self queueInput:point view:sender.view]; // 在显示帧中一次处理
+                }
+                else {
+                    [self flushInput];
+                    ret = [self touchesMoved:point view:sender.view
+                                       count:sender.numberOfTouches];
+                }
+            }
         }
         else if (sender.state == UIGestureRecognizerStateEnded) {
+            [self stopInput];
             if ([sender numberOfTouches] && [self getPointForPressDrag:sender :&point]) {
                 [self convertPoint:point];
             }
@@ -549,6 +610,7 @@ static long s_cmdRef = 0;
             _motion->dragging = false;
         }
         else {
+            [self stopInput];
             ret = cmd->cancel(_motion);
             _touchCount = 0;
             _motion->dragging = false;
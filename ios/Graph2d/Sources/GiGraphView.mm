@@ -123,6 +123,7 @@ static void onShapesLocked(MgShapes* sp, void* obj, bool locked)
     if (_shapes && !_scaleReaded) {
         _scaleReaded = YES;
         _graph->xf.setModelTransform(_shapes->modelTransform());
+        _shapes->applyOrigin(_graph->xf);           // 视图中心是相对于文档原点的
         _graph->xf.zoom(_shapes->getViewCenterW(), _shapes->getViewScale());
     }
     
@@ -252,7 +253,7 @@ static void onShapesLocked(MgShapes* sp, void* obj, bool locked)
 }
 
 - (void)regen {
-    _graph->gs.clearCachedBitmap();
+    _graph->gs.clearCachedBitmap(true);     // 含增量显示中的第二个缓冲图
     _buffered |= 1;
     [self setNeedsDisplay];
 }
@@ -108,7 +108,7 @@
 }
 
 - (void)regen {
-    _graph->gs.clearCachedBitmap();
+    _graph->gs.clearCachedBitmap(true);
     _cachedDraw = YES;
     [self setNeedsDisplay];
 }
@@ -245,6 +245,9 @@
     MgShapesLock locker(sp, MgShapesLock::Edit);
     BOOL ret = (locker.locked() && mgstorage
                 && sp->load((MgStorage*)mgstorage));
+    if (ret) {
+        sp->applyOrigin(*[[self gview] xform]);         // 显示原点与文档原点相同
+    }
     [self regen];
     
     return ret;
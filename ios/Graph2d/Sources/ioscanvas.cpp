@@ -600,6 +600,54 @@ bool GiCanvasIos::rawBeziers(const GiContext* ctx, const Point2d* pxs, int count
     return ret;
 }
 
+bool GiCanvasIos::rawLinesBatch(const GiContext* ctx, int lineCount, 
+                                const int* counts, const Point2d* pxs)
+{
+    bool ret = m_draw->setPen(ctx) && lineCount > 0;
+
+    if (ret)                            // 所有折线作为一个路径描绘
+    {
+        for (int k = 0; k < lineCount; pxs += counts[k++])
+        {
+            if (counts[k] < 2)
+                continue;
+            CGContextMoveToPoint(m_draw->getContext(), pxs[0].x, pxs[0].y);
+            for (int i = 1; i < counts[k]; i++) {
+                CGContextAddLineToPoint(m_draw->getContext(), pxs[i].x, pxs[i].y);
+            }
+        }
+        CGContextStrokePath(m_draw->getContext());
+    }
+
+    return ret;
+}
+
+bool GiCanvasIos::rawBeziersBatch(const GiContext* ctx, int curveCount, 
+                                  const int* counts, const Point2d* pxs)
+{
+    bool ret = m_draw->setPen(ctx) && curveCount > 0;
+
+    if (ret)                            // 所有曲线作为一个路径描绘
+    {
+        for (int k = 0; k < curveCount; pxs += counts[k++])
+        {
+            if (counts[k] < 4)
+                continue;
+            CGContextMoveToPoint(m_draw->getContext(), pxs[0].x, pxs[0].y);
+            for (int i = 1; i + 2 < counts[k]; i += 3)
+            {
+                CGContextAddCurveToPoint(m_draw->getContext(), 
+                    pxs[i+0].x, pxs[i+0].y,
+                    pxs[i+1].x, pxs[i+1].y,
+                    pxs[i+2].x, pxs[i+2].y);
+            }
+        }
+        CGContextStrokePath(m_draw->getContext());
+    }
+
+    return ret;
+}
+
 bool GiCanvasIos::rawPolygon(const GiContext* ctx, const Point2d* pxs, int count)
 {
     bool usepen = m_draw->setPen(ctx);
@@ -61,6 +61,8 @@ public:
     virtual bool rawLineTo(float x, float y);
     virtual bool rawBezierTo(const Point2d* pxs, int count);
     virtual bool rawClosePath();
+    virtual bool rawLinesBatch(const GiContext* ctx, int lineCount, 
+        const int* counts, const Point2d* pxs);
     
     virtual bool drawImage(long hmWidth, long hmHeight, HBITMAP hbitmap, 
         const Box2d& rectW, bool fast = false);
@@ -502,6 +502,36 @@ bool GiCanvasGdi::rawLines(const GiContext* ctx,
     return ret;
 }
 
+bool GiCanvasGdi::rawLinesBatch(const GiContext* ctx, int lineCount, 
+                                const int* counts, const Point2d* pxs)
+{
+    HDC hdc = m_draw->getDrawDC();
+    KGDIObject pen (hdc, m_draw->createPen(ctx), false);
+    bool ret = false;
+
+    if (lineCount > 0)
+    {
+        std::vector<POINT> pts;
+        std::vector<DWORD> nums;
+        for (int k = 0; k < lineCount; pxs += counts[k++])
+        {
+            if (counts[k] < 2)
+                continue;
+            nums.push_back(counts[k]);
+            for (int i = 0; i < counts[k]; i++)
+            {
+                POINT pt;
+                pxs[i].get(pt.x, pt.y);
+                pts.push_back(pt);
+            }
+        }
+        ret = !nums.empty() && !!PolyPolyline(hdc, &pts.front(),
+            &nums.front(), (DWORD)nums.size());
+    }
+
+    return ret;
+}
+
 bool GiCanvasGdi::rawBeziers(const GiContext* ctx, 
                              const Point2d* pxs, int count)
 {